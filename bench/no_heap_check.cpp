@@ -0,0 +1,201 @@
+/*
+STATIC_PARSER_NO_HEAP check
+
+built with -DSTATIC_PARSER_NO_HEAP (see run.sh), global operator
+new is replaced and counts the calls made while a parse is armed,
+the setup (Context, bindings, verification) is free to allocate.
+
+every parse runs on a monotonic buffer over a static buffer with
+null_memory_resource upstream : the positional index spill and the
+DynamicArr growth land in it, the heap is never touched.
+
+the parses cover a success with every kind of binding, failures
+through run_parse (suggestions formatted into a char buffer) and
+incremental::Validator updates. exits non-zero when a parse allocated
+
+the throwing parse isn't heap-free : the C++ runtime takes the
+exception object from malloc (or its emergency pool), which this
+check doesn't see. it's run and listed as "unchecked", never as ok
+
+    ./no_heap_check
+*/
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <array>
+#include <atomic>
+#include <memory_resource>
+
+#include "ArgParser/static_parser.hpp"
+#include "ArgParser/incremental.hpp"
+
+#ifndef STATIC_PARSER_NO_HEAP
+#error "no_heap_check is built with -DSTATIC_PARSER_NO_HEAP"
+#endif
+
+namespace {
+
+std::atomic<bool> g_armed{false};
+std::atomic<std::size_t> g_armed_allocs{0};
+
+void* counted_alloc(std::size_t size) {
+    if(g_armed.load(std::memory_order_relaxed)) g_armed_allocs.fetch_add(1, std::memory_order_relaxed);
+    if(void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+}
+
+void* operator new(std::size_t size) { return counted_alloc(size); }
+void* operator new[](std::size_t size) { return counted_alloc(size); }
+void* operator new(std::size_t size, std::align_val_t align) {
+    if(g_armed.load(std::memory_order_relaxed)) g_armed_allocs.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t alignment = static_cast<std::size_t>(align);
+    if(void* ptr = std::aligned_alloc(alignment, ((size + alignment - 1) / alignment) * alignment)) return ptr;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size, std::align_val_t align) { return operator new(size, align); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+namespace {
+
+using namespace sp;
+
+static constexpr choice::ChoiceSet formats{ "json", "csv", "binary" };
+enum class Format { kJson, kCsv, kBinary };
+
+static constexpr Context<9, 8, 1> ctx(
+    dnOpt()("--jobs")["-j"].nargs(1).restricted().convert(codeInt),
+    snOpt()("--level").nargs(1).restricted().convert(codeInt),
+    snOpt()("--sizes").nargs(1).convert(codeInt),
+    snOpt()("--format").nargs(1).restricted().choices(formats),
+    snOpt()("--color").nargs(1).restricted().convert(codeBool),
+    snOpt()("--name").nargs(1).restricted().convert(codeStr),
+    snOpt()("--limit").nargs(1).restricted().convert(codeI64),
+    posArg()("files").nargs(1).convert(codeStr)
+);
+
+struct Bindings {
+    std::array<ModProf, 8> mprofs{};
+    IntT jobs = 0;
+    Lazy<IntT> level;
+    std::array<Blob, 4> size_storage{};
+    ArrT sizes{ size_storage };
+    Format format = Format::kJson;
+    BoolT color = false;
+    StrT name = nullptr;
+    I64T limit = 0;
+    DynamicArr files;
+    mapper::RuntimeMapper<9> rmap;
+
+    explicit Bindings(std::pmr::memory_resource* resource) : rmap(ctx.mapper, mprofs, resource) {
+        mprofs[0].bind(jobs);
+        mprofs[1].bind(level);
+        mprofs[2].bind(sizes);
+        mprofs[3].bind(format);
+        mprofs[4].bind(color);
+        mprofs[5].bind(name);
+        mprofs[6].bind(limit);
+        mprofs[7].bind(files);
+        rmap.verify();
+    }
+};
+
+alignas(std::max_align_t) unsigned char g_buffer[64 * 1024];
+
+int g_failed = 0;
+
+// runs one armed parse, the arena is rewound first (one per command line)
+template <typename ParseF>
+void check(const char* label, std::pmr::monotonic_buffer_resource& arena, Bindings& bind, const ParseF& parse_once) {
+    bind.rmap.reset();
+    arena.release();
+    bind.rmap.set_resource(&arena);
+
+    g_armed_allocs.store(0, std::memory_order_relaxed);
+    g_armed.store(true, std::memory_order_relaxed);
+    const bool ok = parse_once();
+    g_armed.store(false, std::memory_order_relaxed);
+
+    const std::size_t allocs = g_armed_allocs.load(std::memory_order_relaxed);
+    std::printf("%-24s %-10s %zu\n", label, ok ? "ok" : "wrong", allocs);
+    if(!ok or allocs) g_failed = 1;
+}
+
+}
+
+int main() {
+    std::pmr::monotonic_buffer_resource arena(g_buffer, sizeof(g_buffer), std::pmr::null_memory_resource());
+    Bindings bind(&arena);
+
+    // more files than the inline positional index, the DynamicArr grows in the arena too
+    const char* success[] = {
+        "a.txt", "b.txt", "c.txt", "d.txt", "e.txt", "f.txt", "g.txt", "h.txt", "i.txt", "j.txt",
+        "k.txt", "l.txt", "m.txt", "n.txt", "o.txt", "p.txt", "q.txt", "r.txt", "s.txt", "t.txt",
+        "-j", "8", "--level=3", "--sizes", "1", "2", "3", "--format", "csv",
+        "--color", "on", "--name", "daemon", "--limit=-9000000000"
+    };
+    const char* unknown[] = { "--jbos", "4" };
+    const char* bad_choice[] = { "--format", "jsno" };
+    const char* bad_number[] = { "--jobs", "x4" };
+
+    std::printf("%-24s %-10s %s\n", "parse", "result", "allocs");
+
+    check("success", arena, bind, [&]() {
+        const parser::ParseFailure fail = parser::run_parse(bind.rmap, success, static_cast<int>(std::size(success)));
+        return !fail and (bind.jobs == 8) and (bind.level.get() == 3) and (bind.format == Format::kCsv)
+            and bind.color and (bind.limit == -9000000000LL) and (bind.files.size() == 20);
+    });
+
+    for(const auto& [label, argv] : { std::pair{ "unknown_option", unknown }, std::pair{ "invalid_choice", bad_choice }, std::pair{ "not_a_number", bad_number } }) {
+        check(label, arena, bind, [&]() {
+            const parser::ParseFailure fail = parser::run_parse(bind.rmap, argv, 2);
+            char msg[256];
+            fail.format(msg);
+            return static_cast<bool>(fail) and (msg[0] != '\0');
+        });
+    }
+
+    // the exception object comes from malloc, only the operator new calls around it are seen
+    {
+        bind.rmap.reset();
+        arena.release();
+        bool thrown = false;
+        g_armed_allocs.store(0, std::memory_order_relaxed);
+        g_armed.store(true, std::memory_order_relaxed);
+        try {
+            parser::parse(bind.rmap, bad_choice, 2, &arena);
+        } catch(const except::ParseError& err) {
+            thrown = (err.what()[0] != '\0');
+        }
+        g_armed.store(false, std::memory_order_relaxed);
+        const std::size_t allocs = g_armed_allocs.load(std::memory_order_relaxed);
+        std::printf("%-24s %-10s %zu (+ the exception object, malloc)\n", "throwing_parse", thrown ? "unchecked" : "wrong", allocs);
+        if(!thrown) g_failed = 1;
+    }
+
+    // a keystroke on the last token, then the line edited in its middle
+    Bindings edit_bind(&arena);
+    incremental::Validator<9> validator(edit_bind.rmap);
+    (void)validator.update(success, static_cast<int>(std::size(success)));
+    for(const std::size_t first_changed : { std::size(success) - 1, std::size_t(22) }) {
+        const char* label = (first_changed == 22) ? "validator_middle_edit" : "validator_last_edit";
+        g_armed_allocs.store(0, std::memory_order_relaxed);
+        g_armed.store(true, std::memory_order_relaxed);
+        const parser::ParseFailure fail = validator.update(success, static_cast<int>(std::size(success)), first_changed);
+        g_armed.store(false, std::memory_order_relaxed);
+
+        const std::size_t allocs = g_armed_allocs.load(std::memory_order_relaxed);
+        std::printf("%-24s %-10s %zu\n", label, fail ? "wrong" : "ok", allocs);
+        if(fail or allocs) g_failed = 1;
+    }
+
+    return g_failed;
+}
@@ -0,0 +1,374 @@
+/*
+Parser benchmark
+
+one binary per schema size (BENCH_OPTIONS, see run.sh),
+every corpus is parsed repeatedly through a verified
+RuntimeMapper, reset between parses as parse_many does.
+
+reported per corpus :
+    tokens        argv size of the corpus
+    ns/token      wall time of one parse / tokens
+    allocs/parse  global operator new calls during one parse
+                  (steady state, after a warm-up parse)
+
+    ./parse_bench                 the generated corpora
+    ./parse_bench --rsp-mb 50     plus a 50 MB @response file
+
+the "lazy:" corpora parse with the numeric options bound to
+values::Lazy, "+read" also reads every given value after the
+parse (the conversions then run on access)
+
+the "edit:" corpora re-validate the line through an
+incremental::Validator after its last token was retyped,
+ns/token stays per token of the whole line
+
+the "dynamic_arr:" rows capture 100k positional tokens into the
+DynamicArr bound to "files", once on the heap resource (the array
+keeps its storage between parses, the allocations left are those
+of the spilled positional index) and once on a monotonic arena over
+a static buffer, released before every parse (both grow again in it)
+
+the "callbacks:" rows time the callback phase alone, 128 called
+profiles each firing one callback capturing three words
+(ns/token is per callback, allocs/parse counts the 128
+registrations instead) :
+    std_function  std::function<void(static_profile, modifiable_profile&)>
+                  as profiles held it before, the profile copied per call
+    inline        modifiable_profile::FunctionType, by reference
+"callbacks:<corpus>" parses the corpus with a callback on every option
+
+the "lookup:" rows time the name lookup alone at 5, 50 and 500
+names (the options column), ns/token is per lookup :
+    dispatch    the compile-time NameDispatcher of Mapper
+    hash_map    std::unordered_map<std::string_view>, standing in
+                for the frozen::unordered_map Mapper used before
+                (frozen isn't a dependency anymore)
+*/
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <new>
+#include <atomic>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <functional>
+#include <unordered_map>
+
+#include "schema_gen.hpp"
+#include "ArgParser/response_file.hpp"
+#include "ArgParser/incremental.hpp"
+
+#ifndef BENCH_OPTIONS
+#define BENCH_OPTIONS 100
+#endif
+
+namespace {
+
+std::atomic<std::size_t> g_allocs{0};
+
+}
+
+void* operator new(std::size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if(void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t alignment = static_cast<std::size_t>(align);
+    if(void* ptr = std::aligned_alloc(alignment, ((size + alignment - 1) / alignment) * alignment)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+void* operator new[](std::size_t size, std::align_val_t align) { return operator new(size, align); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+namespace {
+
+constexpr std::size_t kOptions = BENCH_OPTIONS;
+constexpr std::size_t kTargetTokens = 4'000'000; // per corpus
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    double ns_per_token = 0;
+    double allocs_per_parse = 0;
+    std::size_t parses = 0;
+};
+
+template <typename ParseF>
+Result measure(std::size_t tokens, const ParseF& parse_once) {
+    parse_once(); // warm-up, grows every reusable buffer once
+
+    Result res{};
+    res.parses = (tokens >= kTargetTokens) ? 1 : (kTargetTokens / (tokens ? tokens : 1));
+    const std::size_t allocs_before = g_allocs.load(std::memory_order_relaxed);
+    const Clock::time_point start = Clock::now();
+    for(std::size_t i = 0; i < res.parses; i++) parse_once();
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    const std::size_t allocs = g_allocs.load(std::memory_order_relaxed) - allocs_before;
+
+    res.ns_per_token = ns / static_cast<double>(res.parses * (tokens ? tokens : 1));
+    res.allocs_per_parse = static_cast<double>(allocs) / static_cast<double>(res.parses);
+    return res;
+}
+
+void report(std::size_t options, const char* corpus, std::size_t tokens, const Result& res) {
+    std::printf("%-8zu %-24s %-10zu %-10.2f %-12.2f %zu\n",
+        options, corpus, tokens, res.ns_per_token, res.allocs_per_parse, res.parses);
+}
+
+void report(const char* corpus, std::size_t tokens, const Result& res) { report(kOptions, corpus, tokens, res); }
+
+volatile double g_sink = 0;
+
+// after_parse(bind) runs after every parse, in the measured time
+template <typename BindingsT, typename AfterF>
+bool run_corpus(BindingsT& bind, const bench::Corpus& corpus, const char* label, const AfterF& after_parse) {
+    bind.rmap.reset();
+    sp::parser::ParseFailure first = sp::parser::run_parse(bind.rmap, const_cast<const char**>(corpus.argv.data()), corpus.argc());
+    if(first) {
+        char msg[256];
+        first.format(msg);
+        std::printf("%-8zu %-24s failed : %s\n", kOptions, label, msg);
+        return false;
+    }
+
+    Result res = measure(corpus.argv.size(), [&]() {
+        bind.rmap.reset();
+        (void)sp::parser::run_parse(bind.rmap, const_cast<const char**>(corpus.argv.data()), corpus.argc());
+        after_parse(bind);
+    });
+    report(label, corpus.argv.size(), res);
+    return true;
+}
+
+template <std::size_t N>
+bool run_corpus(bench::Bindings<N>& bind, const bench::Corpus& corpus) {
+    return run_corpus(bind, corpus, corpus.name.c_str(), [](bench::Bindings<N>&) {});
+}
+
+// the corpus with lazy bindings, read or not
+template <std::size_t N>
+void run_lazy_corpus(bench::LazyBindings<N>& bind, const bench::Corpus& corpus) {
+    const std::string unread = "lazy:" + corpus.name;
+    const std::string read = unread + "+read";
+    run_corpus(bind, corpus, unread.c_str(), [](bench::LazyBindings<N>&) {});
+    run_corpus(bind, corpus, read.c_str(), [](bench::LazyBindings<N>& b) { g_sink = g_sink + b.read_all(); });
+}
+
+// the corpus re-validated from its last token, as on a keystroke at the end of the line
+template <std::size_t N, typename ValidatorT>
+void run_edit_corpus(ValidatorT& validator, const bench::Corpus& corpus) {
+    const std::string label = "edit:" + corpus.name;
+    const char** argv = const_cast<const char**>(corpus.argv.data());
+    const std::size_t last = corpus.argv.size() - 1;
+    validator.update(argv, corpus.argc());
+    sp::parser::ParseFailure first = validator.update(argv, corpus.argc(), last);
+    if(first) {
+        char msg[256];
+        first.format(msg);
+        std::printf("%-8zu %-24s failed : %s\n", kOptions, label.c_str(), msg);
+        return;
+    }
+
+    Result res = measure(corpus.argv.size(), [&]() { (void)validator.update(argv, corpus.argc(), last); });
+    report(label.c_str(), corpus.argv.size(), res);
+}
+
+alignas(std::max_align_t) unsigned char g_arena_buffer[16 << 20];
+
+template <std::size_t N>
+void run_dynamic_capture(bench::Bindings<N>& bind) {
+    constexpr std::size_t kValues = 100'000;
+    const bench::Corpus corpus = bench::positional_flood_corpus(kValues);
+    const char** argv = const_cast<const char**>(corpus.argv.data());
+
+    bind.rmap.reset();
+    Result res = measure(kValues, [&]() {
+        bind.rmap.reset();
+        (void)sp::parser::run_parse(bind.rmap, argv, corpus.argc());
+    });
+    if(bind.files.size() != kValues) std::printf("%-8zu %-24s failed : %zu values\n", kOptions, "dynamic_arr:100k", bind.files.size());
+    else report("dynamic_arr:100k", kValues, res);
+
+    std::pmr::monotonic_buffer_resource arena(g_arena_buffer, sizeof(g_arena_buffer), std::pmr::null_memory_resource());
+    res = measure(kValues, [&]() {
+        bind.rmap.reset();
+        arena.release();
+        sp::parser::parse(bind.rmap, argv, corpus.argc(), &arena);
+    });
+    if(bind.files.size() != kValues) std::printf("%-8zu %-24s failed : %zu values\n", kOptions, "dynamic_arr:100k+arena", bind.files.size());
+    else report("dynamic_arr:100k+arena", kValues, res);
+    bind.rmap.reset();
+}
+
+template <std::size_t N>
+void run_callbacks(const bench::Schema<N>& schema) {
+    constexpr std::size_t kCallbacks = 128;
+    using Before = std::function<void(sp::profiles::static_profile, sp::profiles::modifiable_profile&)>;
+    const auto& sprofs = schema.ptable.static_profiles;
+    std::array<std::size_t, kCallbacks> hits{};
+    std::size_t fired = 0;
+
+    std::vector<Before> before(kCallbacks);
+    std::size_t allocs_before = g_allocs.load(std::memory_order_relaxed);
+    for(std::size_t i = 0; i < kCallbacks; i++)
+        before[i] = [&fired, slot = &hits[i], i](sp::profiles::static_profile prof, sp::profiles::modifiable_profile&) { fired += prof.narg + i; ++*slot; };
+    const std::size_t before_allocs = g_allocs.load(std::memory_order_relaxed) - allocs_before;
+
+    static std::array<sp::profiles::modifiable_profile, kCallbacks> after{};
+    allocs_before = g_allocs.load(std::memory_order_relaxed);
+    for(std::size_t i = 0; i < kCallbacks; i++)
+        after[i].set_callback([&fired, slot = &hits[i], i](const sp::profiles::static_profile& prof, sp::profiles::modifiable_profile&) { fired += prof.narg + i; ++*slot; });
+    const std::size_t after_allocs = g_allocs.load(std::memory_order_relaxed) - allocs_before;
+
+    Result res = measure(kCallbacks, [&]() {
+        for(std::size_t i = 0; i < kCallbacks; i++) before[i](sprofs[i % sprofs.size()], after[i]);
+    });
+    res.allocs_per_parse = static_cast<double>(before_allocs);
+    report("callbacks:std_function", kCallbacks, res);
+
+    res = measure(kCallbacks, [&]() {
+        for(std::size_t i = 0; i < kCallbacks; i++) after[i].callback(sprofs[i % sprofs.size()], after[i]);
+    });
+    res.allocs_per_parse = static_cast<double>(after_allocs);
+    report("callbacks:inline", kCallbacks, res);
+    g_sink = g_sink + static_cast<double>(fired);
+}
+
+template <std::size_t Names>
+struct LookupNames {
+    static constexpr std::array<sp::dispatch::NameEntry, Names> entries = []() {
+        std::array<sp::dispatch::NameEntry, Names> table{};
+        for(std::size_t i = 0; i < Names; i++) table[i] = { bench::NameTable<Names>::longs[i].data(), i };
+        return table;
+    }();
+    static constexpr sp::dispatch::NameDispatcher<Names> dispatcher{ entries };
+};
+
+// every name in a scattered order, one query in 8 misses
+template <std::size_t Names>
+void run_lookup() {
+    constexpr std::size_t kQueries = 4096;
+    std::vector<std::string> storage;
+    storage.reserve(kQueries);
+    for(std::size_t q = 0; q < kQueries; q++) {
+        if((q % 8) == 7) storage.push_back("--x" + std::to_string(q));
+        else storage.push_back(bench::NameTable<Names>::longs[(q * 7919) % Names].data());
+    }
+    const std::vector<std::string_view> queries(storage.begin(), storage.end());
+
+    std::unordered_map<std::string_view, std::size_t> hash_map;
+    for(const sp::dispatch::NameEntry& entry : LookupNames<Names>::entries) hash_map.emplace(entry.name, entry.value);
+
+    std::size_t found = 0;
+    Result res = measure(kQueries, [&]() {
+        for(std::string_view name : queries) found += (LookupNames<Names>::dispatcher.find(name) != sp::dispatch::npos);
+    });
+    report(Names, "lookup:dispatch", kQueries, res);
+
+    res = measure(kQueries, [&]() {
+        for(std::string_view name : queries) found += (hash_map.find(name) != hash_map.end());
+    });
+    report(Names, "lookup:hash_map", kQueries, res);
+    g_sink = g_sink + static_cast<double>(found);
+}
+
+template <std::size_t N>
+void run_response_file(bench::Bindings<N>& bind, std::size_t megabytes) {
+    const char* path = "parse_bench.rsp";
+    std::size_t tokens = 0;
+    {
+        std::ofstream out(path, std::ios::binary);
+        std::size_t written = 0;
+        char line[32];
+        while(written < (megabytes << 20)) {
+            int len = std::snprintf(line, sizeof(line), "file_%zu.o\n", tokens++);
+            out.write(line, len);
+            written += static_cast<std::size_t>(len);
+        }
+    }
+
+    const char* argv[] = { "@parse_bench.rsp" };
+    Result res{};
+    res.parses = 1;
+    {
+        sp::parser::ResponseFiles<> rsp;
+        bind.rmap.reset();
+        const std::size_t allocs_before = g_allocs.load(std::memory_order_relaxed);
+        const Clock::time_point start = Clock::now();
+        sp::parser::ParseFailure fail = sp::parser::run_parse(bind.rmap, argv, 1, rsp);
+        const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        res.allocs_per_parse = static_cast<double>(g_allocs.load(std::memory_order_relaxed) - allocs_before);
+        res.ns_per_token = ns / static_cast<double>(tokens);
+        if(fail) {
+            char msg[256];
+            fail.format(msg);
+            std::printf("%-8zu %-24s failed : %s\n", kOptions, "response_file", msg);
+        } else {
+            report("response_file", tokens, res);
+        }
+    }
+    std::remove(path);
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::size_t rsp_mb = 0;
+    for(int i = 1; i < argc; i++) {
+        if((std::strcmp(argv[i], "--rsp-mb") == 0) and ((i + 1) < argc)) rsp_mb = std::strtoul(argv[++i], nullptr, 10);
+    }
+
+    const auto& schema = bench::SchemaOf<kOptions>::value;
+    static bench::Bindings<kOptions> bind(schema);
+
+    std::printf("# schema : %zu options, %zu names, Context %zu bytes\n",
+        kOptions, schema.id_count, sizeof(schema));
+    std::printf("%-8s %-24s %-10s %-10s %-12s %s\n", "options", "corpus", "tokens", "ns/token", "allocs/parse", "parses");
+
+    run_corpus(bind, bench::realistic_corpus<kOptions>());
+    run_corpus(bind, bench::every_option_corpus<kOptions>());
+    run_corpus(bind, bench::value_runs_corpus<kOptions>());
+    run_corpus(bind, bench::attached_short_corpus<kOptions>());
+    run_corpus(bind, bench::positional_flood_corpus(200'000));
+    run_dynamic_capture(bind);
+    if(rsp_mb) run_response_file(bind, rsp_mb);
+
+    static bench::LazyBindings<kOptions> lazy_bind(schema);
+    run_lazy_corpus(lazy_bind, bench::realistic_corpus<kOptions>());
+    run_lazy_corpus(lazy_bind, bench::every_option_corpus<kOptions>());
+    run_lazy_corpus(lazy_bind, bench::value_runs_corpus<kOptions>());
+
+    static bench::Bindings<kOptions> edit_bind(schema);
+    static sp::incremental::Validator<bench::schema_ids<kOptions>(), 64, 4096> validator(edit_bind.rmap);
+    run_edit_corpus<kOptions>(validator, bench::realistic_corpus<kOptions>());
+    run_edit_corpus<kOptions>(validator, bench::every_option_corpus<kOptions>());
+    run_edit_corpus<kOptions>(validator, bench::value_runs_corpus<kOptions>());
+
+    static bench::Bindings<kOptions> callback_bind(schema);
+    std::size_t fired = 0;
+    for(std::size_t i = 0; i < kOptions; i++)
+        callback_bind.mprofs[i].set_callback([&fired](const sp::profiles::static_profile& prof, sp::profiles::modifiable_profile&) { fired += prof.narg; });
+    run_corpus(callback_bind, bench::every_option_corpus<kOptions>(), "callbacks:every_option", [](bench::Bindings<kOptions>&) {});
+    run_callbacks<kOptions>(schema);
+    g_sink = g_sink + static_cast<double>(fired);
+
+    run_lookup<5>();
+    run_lookup<50>();
+    run_lookup<500>();
+    return 0;
+}
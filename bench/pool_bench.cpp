@@ -0,0 +1,72 @@
+/*
+ContextPool scaling benchmark
+
+one shared Context, a pool of 64 pre-verified bindings,
+1 to 64 threads each lease an entry, parse the realistic
+corpus and hand it back. with no shared cache line on the
+parse path, parses/s should grow with the thread count
+up to the core count, efficiency is relative to 1 thread.
+
+    ./pool_bench [parses per thread]
+*/
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "schema_gen.hpp"
+#include "ArgParser/pool.hpp"
+
+#ifndef BENCH_OPTIONS
+#define BENCH_OPTIONS 100
+#endif
+
+namespace {
+
+constexpr std::size_t kOptions = BENCH_OPTIONS;
+constexpr std::size_t kPoolSlots = 64;
+
+using Clock = std::chrono::steady_clock;
+using Pool = sp::pool::ContextPool<bench::Bindings<kOptions>, kPoolSlots>;
+
+}
+
+int main(int argc, char** argv) {
+    const std::size_t per_thread = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 50'000;
+    static Pool pool(bench::SchemaOf<kOptions>::value);
+    const bench::Corpus corpus = bench::realistic_corpus<kOptions>();
+    const char** args = const_cast<const char**>(corpus.argv.data());
+
+    std::printf("# %zu options, %zu slots, %u hardware threads, %zu parses per thread\n",
+        kOptions, Pool::capacity(), std::thread::hardware_concurrency(), per_thread);
+    std::printf("%-8s %-14s %-16s %s\n", "threads", "parses/s", "parses/s/thread", "efficiency");
+
+    double single = 0;
+    for(std::size_t threads = 1; threads <= kPoolSlots; threads *= 2) {
+        std::vector<std::thread> workers;
+        std::vector<std::size_t> failures(threads, 0);
+        const Clock::time_point start = Clock::now();
+
+        for(std::size_t t = 0; t < threads; t++) {
+            workers.emplace_back([&, t]() {
+                for(std::size_t i = 0; i < per_thread; i++) {
+                    Pool::Lease lease = pool.acquire();
+                    if(sp::parser::run_parse(lease->rmap, args, corpus.argc())) ++failures[t];
+                }
+            });
+        }
+        for(std::thread& worker : workers) worker.join();
+
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        const double rate = static_cast<double>(threads * per_thread) / seconds;
+        if(threads == 1) single = rate;
+
+        std::size_t failed = 0;
+        for(std::size_t f : failures) failed += f;
+        std::printf("%-8zu %-14.0f %-16.0f %.2f%s\n",
+            threads, rate, rate / threads, rate / (single * threads),
+            failed ? " (parse failures !)" : "");
+    }
+    return 0;
+}
@@ -0,0 +1,43 @@
+#!/bin/sh
+# Builds parse_bench once per schema size, prints the binary size of each
+# and runs it. extra arguments go to every parse_bench run (e.g. --rsp-mb 50)
+# then builds and runs the ContextPool scaling benchmark (1 to 64 threads)
+# and the STATIC_PARSER_NO_HEAP check (fails on any allocation during a
+# non-throwing parse)
+#
+#   CXX=clang++ ./bench/run.sh
+#   SIZES="10 100" ./bench/run.sh --rsp-mb 50
+#   POOL_PARSES=200000 ./bench/run.sh
+
+set -e
+
+CXX=${CXX:-g++}
+SIZES=${SIZES:-"10 100 1000 2000"}
+HERE=$(cd "$(dirname "$0")" && pwd)
+OUT=${OUT:-"$HERE/out"}
+
+mkdir -p "$OUT"
+
+for n in $SIZES; do
+    bin="$OUT/parse_bench_$n"
+    "$CXX" -std=c++20 -O2 -DNDEBUG -DBENCH_OPTIONS="$n" \
+        -fconstexpr-ops-limit=1000000000 -fconstexpr-loop-limit=1000000 \
+        -I"$HERE/../include" -I"$HERE" \
+        "$HERE/parse_bench.cpp" -o "$bin"
+    strip -o "$bin.stripped" "$bin"
+    echo "# binary size ($n options) : $(wc -c < "$bin.stripped") bytes stripped, $(wc -c < "$bin") bytes"
+    (cd "$OUT" && "$bin" "$@")
+    echo
+done
+
+bin="$OUT/pool_bench"
+"$CXX" -std=c++20 -O2 -DNDEBUG -pthread \
+    -I"$HERE/../include" -I"$HERE" \
+    "$HERE/pool_bench.cpp" -o "$bin"
+"$bin" ${POOL_PARSES:-}
+
+bin="$OUT/no_heap_check"
+"$CXX" -std=c++20 -O2 -DNDEBUG -DSTATIC_PARSER_NO_HEAP \
+    -I"$HERE/../include" -I"$HERE" \
+    "$HERE/no_heap_check.cpp" -o "$bin"
+"$bin"
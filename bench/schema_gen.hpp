@@ -0,0 +1,293 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <string>
+#include <utility>
+
+#include "ArgParser/static_parser.hpp"
+
+namespace bench {
+
+using namespace sp;
+
+/*
+Synthetic schema generator
+
+SchemaOf<N>::value is a Context of N options plus one posarg
+at compile time, option i is :
+    - a dnOpt (--o<i> and -<letter>) for the first 52 options,
+      a snOpt (--o<i>) afterwards
+    - converting by i % 4 : int, double, string, int array
+      (non-restricted narg 1, bound to 4 slots, so it takes runs)
+
+the posarg "files" takes every positional token into a DynamicArr.
+Bindings allocates the storage and binds a RuntimeMapper to it.
+*/
+
+enum class Kind : std::uint8_t { kInt = 0, kDob, kStr, kArr };
+
+constexpr std::size_t kShortNames = 52;
+constexpr std::size_t kArrSlots = 4;
+
+constexpr Kind kind_of(std::size_t i) noexcept { return static_cast<Kind>(i % 4); }
+
+constexpr char short_char(std::size_t i) noexcept {
+    return (i < 26) ? static_cast<char>('a' + i) : static_cast<char>('A' + (i - 26));
+}
+
+template <std::size_t N>
+struct NameTable {
+    static constexpr std::array<std::array<char, 8>, N> longs = []() {
+        std::array<std::array<char, 8>, N> table{};
+        for(std::size_t i = 0; i < N; i++) {
+            char digits[6]{};
+            std::size_t len = 0;
+            std::size_t val = i;
+            do { digits[len++] = static_cast<char>('0' + (val % 10)); val /= 10; } while(val);
+
+            std::size_t pos = 0;
+            table[i][pos++] = '-';
+            table[i][pos++] = '-';
+            table[i][pos++] = 'o';
+            while(len) table[i][pos++] = digits[--len];
+            table[i][pos] = '\0';
+        }
+        return table;
+    }();
+
+    static constexpr std::array<std::array<char, 3>, kShortNames> shorts = []() {
+        std::array<std::array<char, 3>, kShortNames> table{};
+        for(std::size_t i = 0; i < kShortNames; i++) table[i] = { '-', short_char(i), '\0' };
+        return table;
+    }();
+};
+
+template <typename Prof>
+constexpr Prof with_kind(Prof prof, Kind kind) {
+    switch(kind) {
+        case Kind::kInt : return prof.nargs(1).restricted().convert(codeInt);
+        case Kind::kDob : return prof.nargs(1).restricted().convert(codeDob);
+        case Kind::kStr : return prof.nargs(1).restricted().convert(codeStr);
+        default : return prof.nargs(1).convert(codeInt);
+    }
+}
+
+template <std::size_t N, std::size_t I>
+constexpr auto make_option() {
+    if constexpr (I < kShortNames)
+        return with_kind(dnOpt()(NameTable<N>::longs[I].data())[NameTable<N>::shorts[I].data()], kind_of(I));
+    else
+        return with_kind(snOpt()(NameTable<N>::longs[I].data()), kind_of(I));
+}
+
+template <std::size_t N>
+constexpr std::size_t schema_ids() noexcept {
+    return N + ((N < kShortNames) ? N : kShortNames) + 1;
+}
+
+template <std::size_t N>
+using Schema = Context<schema_ids<N>(), N + 1, 1>;
+
+/*
+the schema is direct-initialized as a static member, returning a
+Context from a constexpr function isn't usable in constant
+expressions on some compilers (its mapper points into itself)
+*/
+template <std::size_t N, typename Seq = std::make_index_sequence<N>>
+struct SchemaOf;
+
+template <std::size_t N, std::size_t... Is>
+struct SchemaOf<N, std::index_sequence<Is...>> {
+    static constexpr Schema<N> value{ make_option<N, Is>()..., posArg()("files").nargs(1).convert(codeStr) };
+};
+
+template <std::size_t N>
+struct Bindings {
+    std::array<ModProf, N + 1> mprofs{};
+    std::array<IntT, N> ints{};
+    std::array<DobT, N> dobs{};
+    std::array<StrT, N> strs{};
+    std::array<std::array<Blob, kArrSlots>, N> arr_storage{};
+    std::array<ArrT, N> arrs{};
+    DynamicArr files;
+    mapper::RuntimeMapper<schema_ids<N>()> rmap;
+
+    explicit Bindings(const Schema<N>& schema, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : rmap(schema.mapper, mprofs, resource)
+    {
+        for(std::size_t i = 0; i < N; i++) {
+            switch(kind_of(i)) {
+                case Kind::kInt : mprofs[i].bind(ints[i]); break;
+                case Kind::kDob : mprofs[i].bind(dobs[i]); break;
+                case Kind::kStr : mprofs[i].bind(strs[i]); break;
+                case Kind::kArr :
+                    arrs[i] = ArrT(arr_storage[i]);
+                    mprofs[i].bind(arrs[i]);
+                    break;
+            }
+        }
+        mprofs[N].bind(files);
+        rmap.verify();
+    }
+
+    Bindings(const Bindings&) = delete;
+    Bindings& operator=(const Bindings&) = delete;
+
+    void reset() { rmap.reset(); }
+};
+
+/*
+LazyBindings binds the int / double / int array options to
+values::Lazy (their tokens are only recorded), strings and
+the posarg as Bindings does. read_all() reads every value
+that was given, as a program using all of them would
+*/
+template <std::size_t N>
+struct LazyBindings {
+    std::array<ModProf, N + 1> mprofs{};
+    std::array<Lazy<IntT>, N> ints{};
+    std::array<Lazy<DobT>, N> dobs{};
+    std::array<StrT, N> strs{};
+    std::array<Lazy<IntT, kArrSlots>, N> arrs{};
+    DynamicArr files;
+    mapper::RuntimeMapper<schema_ids<N>()> rmap;
+
+    explicit LazyBindings(const Schema<N>& schema, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : rmap(schema.mapper, mprofs, resource)
+    {
+        for(std::size_t i = 0; i < N; i++) {
+            switch(kind_of(i)) {
+                case Kind::kInt : mprofs[i].bind(ints[i]); break;
+                case Kind::kDob : mprofs[i].bind(dobs[i]); break;
+                case Kind::kStr : mprofs[i].bind(strs[i]); break;
+                case Kind::kArr : mprofs[i].bind(arrs[i]); break;
+            }
+        }
+        mprofs[N].bind(files);
+        rmap.verify();
+    }
+
+    LazyBindings(const LazyBindings&) = delete;
+    LazyBindings& operator=(const LazyBindings&) = delete;
+
+    void reset() { rmap.reset(); }
+
+    // sum of every value given (the called options), so the conversions aren't optimized out
+    double read_all() const {
+        double sum = 0;
+        rmap.called_set().for_each([&](std::size_t i) {
+            if(i >= N) return;
+            switch(kind_of(i)) {
+                case Kind::kInt : sum += ints[i].get(); break;
+                case Kind::kDob : sum += dobs[i].get(); break;
+                case Kind::kArr : for(IntT v : arrs[i].values()) sum += v; break;
+                default : break;
+            }
+        });
+        return sum;
+    }
+};
+
+// owns the strings of a generated argv
+struct Corpus {
+    std::string name;
+    std::vector<std::string> storage{};
+    std::vector<const char*> argv{};
+
+    explicit Corpus(std::string corpus_name) : name(std::move(corpus_name)) {}
+
+    void push(std::string token) { storage.push_back(std::move(token)); }
+
+    void seal() {
+        argv.clear();
+        for(const std::string& token : storage) argv.push_back(token.c_str());
+    }
+
+    int argc() const noexcept { return static_cast<int>(argv.size()); }
+};
+
+inline std::string value_of(Kind kind, std::size_t seed) {
+    switch(kind) {
+        case Kind::kInt : return std::to_string(static_cast<int>(seed * 7919 % 100000));
+        case Kind::kDob : return std::to_string(static_cast<double>(seed % 1000) / 8.0);
+        case Kind::kStr : return "value_" + std::to_string(seed);
+        default : return std::to_string(static_cast<int>(seed % 1000));
+    }
+}
+
+template <std::size_t N>
+std::string long_name(std::size_t i) { return NameTable<N>::longs[i].data(); }
+
+/*
+realistic : a few files then ~24 options spread over the schema,
+a mix of "--name value", "--name=value" and short names
+(files first, array options would take them as values)
+*/
+template <std::size_t N>
+Corpus realistic_corpus() {
+    Corpus corpus{ "realistic" };
+    for(std::size_t k = 0; k < 4; k++) corpus.push("file_" + std::to_string(k) + ".txt");
+    const std::size_t used = (N < 24) ? N : 24;
+    const std::size_t stride = N / used;
+    for(std::size_t k = 0; k < used; k++) {
+        const std::size_t i = k * stride;
+        const Kind kind = kind_of(i);
+        if((k % 3 == 0) and (i < kShortNames)) {
+            corpus.push(NameTable<N>::shorts[i].data());
+            corpus.push(value_of(kind, k));
+        } else if(k % 3 == 1) {
+            corpus.push(long_name<N>(i) + "=" + value_of(kind, k));
+        } else {
+            corpus.push(long_name<N>(i));
+            corpus.push(value_of(kind, k));
+            if(kind == Kind::kArr) corpus.push(value_of(kind, k + 1));
+        }
+    }
+    corpus.seal();
+    return corpus;
+}
+
+// adversarial : every option of the schema once, with '=' (widest dispatcher footprint)
+template <std::size_t N>
+Corpus every_option_corpus() {
+    Corpus corpus{ "every_option" };
+    for(std::size_t i = 0; i < N; i++)
+        corpus.push(long_name<N>(i) + "=" + value_of(kind_of(i), i));
+    corpus.seal();
+    return corpus;
+}
+
+// adversarial : every array option with a full run of values (batch conversion path)
+template <std::size_t N>
+Corpus value_runs_corpus() {
+    Corpus corpus{ "value_runs" };
+    for(std::size_t i = 0; i < N; i++) {
+        if(kind_of(i) != Kind::kArr) continue;
+        corpus.push(long_name<N>(i));
+        for(std::size_t k = 0; k < kArrSlots; k++) corpus.push(std::to_string(static_cast<int>(i * 31 + k * 1000003)));
+    }
+    corpus.seal();
+    return corpus;
+}
+
+// adversarial : short names with attached values ("-a123"), cluster path after a dispatcher miss
+template <std::size_t N>
+Corpus attached_short_corpus() {
+    Corpus corpus{ "attached_short" };
+    const std::size_t shorts = (N < kShortNames) ? N : kShortNames;
+    for(std::size_t i = 0; i < shorts; i++)
+        corpus.push(NameTable<N>::shorts[i].data() + value_of(kind_of(i), i));
+    corpus.seal();
+    return corpus;
+}
+
+// adversarial : a flood of positional tokens (positional index spill, DynamicArr growth)
+inline Corpus positional_flood_corpus(std::size_t count) {
+    Corpus corpus{ "positional_flood" };
+    for(std::size_t k = 0; k < count; k++) corpus.push("f" + std::to_string(k));
+    corpus.seal();
+    return corpus;
+}
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <array>
+#include <span>
+#include <string_view>
+
+#include "commons.hpp"
+#include "exceptions.hpp"
+#include "dispatch.hpp"
+#include "suggest.hpp"
+
+namespace sp {
+namespace choice {
+
+/*
+Choice conversion (codeChoice)
+
+the allowed words of a profile are a ChoiceSet, built during
+constant evaluation on the NameDispatcher perfect hash, a token
+maps to the index of its word with one hash and one compare :
+
+    static constexpr choice::ChoiceSet formats{ "json", "csv", "tsv", "binary" };
+    enum class Format { kJson, kCsv, kTsv, kBinary };
+
+    static constexpr Context<...> ctx(
+        snOpt()("--format").nargs(1).restricted().choices(formats)
+    );
+    Format fmt = Format::kJson;
+    mprofs[0].bind(fmt);
+
+choices() sets codeChoice, the ChoiceSet must be a static
+constexpr object (the profile keeps a view of it).
+an enum receives the index, an array a Blob of IntT.
+a word out of the set fails with kInvalidChoice,
+suggesting the closest allowed ones
+*/
+
+/*
+type erased view of a ChoiceSet, what a static_profile keeps
+*/
+struct ChoiceView {
+    using LookupF = dispatch::IndexT (*)(const void* set, std::string_view word) noexcept;
+
+    const void* set = nullptr;
+    LookupF lookup = nullptr;
+    std::span<const NameType> words{};
+    std::span<const suggest::Entry> hints{};
+
+    constexpr explicit operator bool() const noexcept { return set != nullptr; }
+
+    // index of word, dispatch::npos when it isn't allowed
+    constexpr dispatch::IndexT find(std::string_view word) const noexcept { return lookup(set, word); }
+};
+
+template <std::size_t N>
+class ChoiceSet {
+    static_assert(N > 0, "ChoiceSet needs a word");
+
+    private :
+    std::array<NameType, N> word_list{};
+    dispatch::NameDispatcher<N> table;
+    suggest::SuggestIndex<N> hint_index;
+
+    static constexpr std::array<dispatch::NameEntry, N> entries_of(const std::array<NameType, N>& words) {
+        std::array<dispatch::NameEntry, N> entries{};
+        for(std::size_t i = 0; i < N; i++) {
+            if(!words[i] or !words[i][0])
+                throw except::comtime_except("Empty word in ChoiceSet");
+            entries[i] = dispatch::NameEntry{ words[i], i };
+        }
+        return entries;
+    }
+
+    static constexpr dispatch::IndexT lookup(const void* set, std::string_view word) noexcept {
+        return static_cast<const ChoiceSet*>(set)->find(word);
+    }
+
+    public :
+    ChoiceSet() = delete;
+
+    template <typename... Words>
+    constexpr ChoiceSet(const Words&... words)
+        : word_list{ static_cast<NameType>(words)... },
+          table(entries_of(word_list)),
+          hint_index(entries_of(word_list)) {}
+
+    constexpr dispatch::IndexT find(std::string_view word) const noexcept { return table.find(word); }
+
+    constexpr std::span<const NameType> words() const noexcept { return word_list; }
+
+    constexpr ChoiceView view() const noexcept {
+        return ChoiceView{ this, &ChoiceSet::lookup, word_list, hint_index.view() };
+    }
+
+    static constexpr std::size_t size() noexcept { return N; }
+};
+
+template <typename... Words>
+ChoiceSet(const Words&...) -> ChoiceSet<sizeof...(Words)>;
+
+}
+}
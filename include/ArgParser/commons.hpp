@@ -3,6 +3,7 @@
 #include <variant>
 #include <utility>
 #include <span>
+#include <memory_resource>
 
 namespace sp {
 
@@ -14,9 +15,30 @@ using FlagType = std::uint32_t;
 using IntT = int;
 using DobT = double;
 using StrT = const char*;
+using I64T = std::int64_t;
+using U64T = std::uint64_t;
+using FltT = float;
+using BoolT = bool;
 
-using Blob = std::variant<std::monostate, IntT, DobT, StrT>;
+using Blob = std::variant<std::monostate, IntT, DobT, StrT, I64T, U64T, FltT, BoolT>;
 
 using ArrT = std::span<Blob>;
 
+/*
+resource taken when none is given : the heap one, or with
+STATIC_PARSER_NO_HEAP the null one, the parse storage then
+has to come from a caller resource (running out of it throws
+std::bad_alloc instead of falling back to operator new).
+only the non-throwing paths (run_parse, try_parse, Validator::update)
+are heap-free, a throwing parse still gets its exception object
+from the C++ runtime (malloc or its emergency pool)
+*/
+inline std::pmr::memory_resource* default_resource() noexcept {
+    #ifdef STATIC_PARSER_NO_HEAP
+    return std::pmr::null_memory_resource();
+    #else
+    return std::pmr::get_default_resource();
+    #endif
+}
+
 }
\ No newline at end of file
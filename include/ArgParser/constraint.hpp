@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <bit>
+#include <span>
+#include <limits>
+
+#include "exceptions.hpp"
+#include "profiles.hpp"
+
+namespace sp {
+namespace constraint {
+
+/*
+Constraint engine
+
+the Mapper derives its masks from the profiles at compile time :
+    required   profiles with kRequired
+    exclusive  profiles with an exclude_point, profiles sharing
+               an exclude_point are mutually exclusive
+
+the RuntimeMapper tracks the profiles called during a parse
+in a BitSet of the same width, so the end of a parse checks
+(required & ~called) and (exclusive & called) a word at a time,
+callbacks and reset() only visit the called profiles.
+call_limit is checked as each call is counted
+*/
+
+template <std::size_t Bits>
+class BitSet {
+    public :
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+    static constexpr std::size_t word_count = (Bits + 63) / 64;
+
+    private :
+    std::array<std::uint64_t, word_count> words{};
+
+    public :
+    constexpr void set(std::size_t i) noexcept { words[i / 64] |= (std::uint64_t(1) << (i % 64)); }
+    constexpr bool test(std::size_t i) const noexcept { return (words[i / 64] >> (i % 64)) & 1; }
+    constexpr void unset(std::size_t i) noexcept { words[i / 64] &= ~(std::uint64_t(1) << (i % 64)); }
+    constexpr void clear() noexcept { words.fill(0); }
+
+    constexpr bool any() const noexcept {
+        for(std::uint64_t word : words) {
+            if(word) return true;
+        }
+        return false;
+    }
+
+    constexpr std::size_t count() const noexcept {
+        std::size_t res = 0;
+        for(std::uint64_t word : words) res += std::popcount(word);
+        return res;
+    }
+
+    // first bit set in *this and not in oth, npos if none
+    constexpr std::size_t first_not_in(const BitSet& oth) const noexcept {
+        for(std::size_t w = 0; w < word_count; w++) {
+            if(const std::uint64_t left = words[w] & ~oth.words[w])
+                return (w * 64) + std::countr_zero(left);
+        }
+        return npos;
+    }
+
+    constexpr BitSet operator&(const BitSet& oth) const noexcept {
+        BitSet res{};
+        for(std::size_t w = 0; w < word_count; w++) res.words[w] = words[w] & oth.words[w];
+        return res;
+    }
+
+    // func(index) for every set bit, in ascending order
+    template <typename F>
+    constexpr void for_each(const F& func) const {
+        for(std::size_t w = 0; w < word_count; w++) {
+            std::uint64_t word = words[w];
+            while(word) {
+                func((w * 64) + std::countr_zero(word));
+                word &= word - 1;
+            }
+        }
+    }
+};
+
+template <std::size_t Bits>
+struct Masks {
+    BitSet<Bits> required{};
+    BitSet<Bits> exclusive{};
+};
+
+template <std::size_t Bits>
+constexpr Masks<Bits> make_masks(std::span<const profiles::static_profile> profs) {
+    if(profs.size() > Bits)
+        throw except::comtime_except("More profiles than constraint mask bits");
+
+    Masks<Bits> masks{};
+    for(std::size_t i = 0; i < profs.size(); i++) {
+        if(profiles::is_required(profs[i].behave)) masks.required.set(i);
+        if(profs[i].exclude_point < 0) continue;
+        masks.exclusive.set(i);
+
+        for(std::size_t k = 0; k < i; k++) {
+            if(
+                (profs[k].exclude_point == profs[i].exclude_point)
+                and profiles::is_required(profs[k].behave) and profiles::is_required(profs[i].behave)
+            ) throw except::comtime_except("Two required profiles share an exclusion point");
+        }
+    }
+    return masks;
+}
+
+}
+}
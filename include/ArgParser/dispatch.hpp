@@ -0,0 +1,195 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <bit>
+#include <limits>
+#include <string_view>
+
+#include "commons.hpp"
+#include "exceptions.hpp"
+
+namespace sp {
+namespace dispatch {
+
+/*
+NameDispatcher is a compile-time minimal perfect hash
+(hash and displace) from names to an index.
+
+every name is hashed once (FNV-1a), the hash picks a bucket,
+the bucket holds a displacement seed, and the seed remixes
+the same hash into the final slot. a lookup is then
+one pass over the token + one string compare, no probing.
+
+built entirely during constant evaluation, failing to
+find seeds (or duplicated names) is a compile error
+*/
+
+using IndexT = std::size_t;
+static constexpr IndexT npos = std::numeric_limits<IndexT>::max();
+
+struct NameEntry {
+    NameType name = nullptr;
+    IndexT value = npos;
+};
+
+constexpr std::uint64_t name_hash(std::string_view name) noexcept {
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for(char c : name) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+constexpr std::uint64_t remix(std::uint64_t h, std::uint64_t seed) noexcept {
+    h ^= seed * 0x9e3779b97f4a7c15ull;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+}
+
+template <std::size_t N>
+class NameDispatcher {
+    public :
+    static constexpr std::size_t bucket_count = std::bit_ceil(N ? N : 1);
+    static constexpr std::size_t slot_count = bucket_count * 2;
+    static constexpr std::uint32_t max_seed = 1u << 20;
+
+    struct Slot {
+        NameType name = nullptr;
+        std::size_t len = 0;
+        IndexT value = npos;
+    };
+
+    private :
+    std::array<Slot, slot_count> slots{};
+    std::array<std::uint32_t, bucket_count> seeds{}; // 0 = empty bucket
+
+    static constexpr std::size_t bucket_of(std::uint64_t h) noexcept {
+        return remix(h, 0) & (bucket_count - 1);
+    }
+
+    static constexpr std::size_t slot_of(std::uint64_t h, std::uint32_t seed) noexcept {
+        return remix(h, seed) & (slot_count - 1);
+    }
+
+    public :
+
+    NameDispatcher() = delete;
+    constexpr NameDispatcher(const std::array<NameEntry, N>& entries) {
+        std::array<std::uint64_t, N> hashes{};
+        std::array<std::size_t, bucket_count + 1> bucket_start{};
+        std::array<std::size_t, N> order{};
+        std::array<bool, slot_count> taken{};
+
+        for(std::size_t i = 0; i < N; i++) {
+            if(!entries[i].name)
+                throw except::comtime_except("nullptr name in dispatcher entries");
+            hashes[i] = name_hash(entries[i].name);
+            ++bucket_start[bucket_of(hashes[i]) + 1];
+        }
+
+        // counting sort : order[bucket_start[b] .. bucket_start[b + 1]) are the items of bucket b
+        std::size_t max_bucket = 0;
+        for(std::size_t b = 0; b < bucket_count; b++) {
+            if(bucket_start[b + 1] > max_bucket) max_bucket = bucket_start[b + 1];
+            bucket_start[b + 1] += bucket_start[b];
+        }
+        {
+            std::array<std::size_t, bucket_count> fill_pos{};
+            for(std::size_t b = 0; b < bucket_count; b++) fill_pos[b] = bucket_start[b];
+            for(std::size_t i = 0; i < N; i++) order[fill_pos[bucket_of(hashes[i])]++] = i;
+        }
+
+        // largest buckets first, they are the hardest to place
+        for(std::size_t size = max_bucket; size > 0; size--) {
+            for(std::size_t b = 0; b < bucket_count; b++) {
+                const std::size_t first = bucket_start[b];
+                const std::size_t last = bucket_start[b + 1];
+                if((last - first) != size) continue;
+
+                // equal hashes always share a bucket, so checking inside the bucket is enough
+                for(std::size_t k = first; k < last; k++) {
+                    for(std::size_t p = first; p < k; p++) {
+                        if(hashes[order[k]] != hashes[order[p]]) continue;
+                        if(std::string_view(entries[order[k]].name) == std::string_view(entries[order[p]].name))
+                            throw except::comtime_except("Duplicate name in dispatcher entries");
+                        throw except::comtime_except("Name hash collision in dispatcher entries");
+                    }
+                }
+
+                std::uint32_t seed = 1;
+                for(; seed < max_seed; seed++) {
+                    bool placed = true;
+                    for(std::size_t k = first; placed && (k < last); k++) {
+                        std::size_t s = slot_of(hashes[order[k]], seed);
+                        if(taken[s]) { placed = false; break; }
+                        for(std::size_t p = first; p < k; p++)
+                            if(slot_of(hashes[order[p]], seed) == s) { placed = false; break; }
+                    }
+                    if(placed) break;
+                }
+
+                if(seed >= max_seed)
+                    throw except::comtime_except("Failed to find a displacement seed for name dispatcher");
+
+                seeds[b] = seed;
+                for(std::size_t k = first; k < last; k++) {
+                    const NameEntry& entry = entries[order[k]];
+                    std::size_t s = slot_of(hashes[order[k]], seed);
+                    taken[s] = true;
+                    slots[s] = Slot{ entry.name, std::string_view(entry.name).size(), entry.value };
+                }
+            }
+        }
+    }
+
+    constexpr IndexT find(std::string_view name) const noexcept {
+        const std::uint64_t h = name_hash(name);
+        const std::uint32_t seed = seeds[bucket_of(h)];
+        if(!seed) return npos;
+        const Slot& slot = slots[slot_of(h, seed)];
+        if((slot.len != name.size()) or !slot.name) return npos;
+        return (std::string_view(slot.name, slot.len) == name) ? slot.value : npos;
+    }
+
+    static constexpr std::size_t size() noexcept { return N; }
+};
+
+/*
+ShortTable maps the character of a one character short
+name ("-v" -> 'v') straight to its profile index, a lookup
+is a single indexed load, no hashing. it resolves every
+member of a -xvf cluster and is the fast path of a lone "-v"
+*/
+class ShortTable {
+    public :
+    using SlotT = std::uint16_t;
+    static constexpr SlotT empty = std::numeric_limits<SlotT>::max();
+
+    private :
+    std::array<SlotT, 256> slots{};
+
+    public :
+    constexpr ShortTable() {
+        for(SlotT& slot : slots) slot = empty;
+    }
+
+    constexpr void insert(char c, IndexT value) {
+        if(value >= empty)
+            throw except::comtime_except("Too many profiles for the short name table");
+        SlotT& slot = slots[static_cast<unsigned char>(c)];
+        if(slot != empty)
+            throw except::comtime_except("Duplicate short name in short name table");
+        slot = static_cast<SlotT>(value);
+    }
+
+    constexpr IndexT find(char c) const noexcept {
+        const SlotT slot = slots[static_cast<unsigned char>(c)];
+        return (slot == empty) ? npos : slot;
+    }
+};
+
+}
+}
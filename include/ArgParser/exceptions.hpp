@@ -1,7 +1,9 @@
 #pragma once
 #include <stdexcept>
+#include <memory_resource>
 #ifndef STATIC_PARSER_NO_HEAP
 #include <string>
+#include <string_view>
 #endif
 
 namespace sp {
@@ -21,6 +23,14 @@ use SetupError if a function or procedure is likely
 evaluated when boilerplate is evaluated
 
 use standard exception for helpers, etc.
+
+heap messages live in a std::pmr::string, so a parse
+running on a caller memory_resource can build its
+error text there too (the resource must then outlive
+the exception handling)
+
+with STATIC_PARSER_NO_HEAP the messages are string literals
+only, the resource argument is accepted and ignored
 */
 
 class raw_string_exception : public std::exception {
@@ -31,14 +41,20 @@ class raw_string_exception : public std::exception {
     const char* what() const noexcept { return msg; }
 };
 
+#ifndef STATIC_PARSER_NO_HEAP
 class string_exception : public std::exception {
     private :
-    std::string msg;
+    std::pmr::string msg;
     public :
-    string_exception(const std::string& err_msg) : std::exception(), msg(err_msg) {}
+    string_exception(
+        std::string_view err_msg,
+        std::pmr::memory_resource* res = std::pmr::get_default_resource()
+    ) : std::exception(), msg(err_msg, res) {}
+    string_exception(std::pmr::string&& err_msg) : std::exception(), msg(std::move(err_msg)) {}
 
     const char* what() const noexcept { return msg.data(); }
 };
+#endif
 
 class comtime_except : public raw_string_exception {
     public :
@@ -48,25 +64,40 @@ class comtime_except : public raw_string_exception {
 #ifdef STATIC_PARSER_NO_HEAP
 class ParseError : public raw_string_exception {
     public :
-    ParseError(const char* err_msg) : raw_string_exception(err_msg) {};
+    ParseError(const char* err_msg, std::pmr::memory_resource* = nullptr) : raw_string_exception(err_msg) {};
 };
 
 class SetupError : public raw_string_exception {
     public :
-    SetupError(const char* err_msg) : raw_string_exception(err_msg) {}
+    SetupError(const char* err_msg, std::pmr::memory_resource* = nullptr) : raw_string_exception(err_msg) {}
 };
 
 #else
 
 class ParseError : public string_exception {
     public :
-    ParseError(const std::string& err_msg) : string_exception(err_msg) {};
-    
+    ParseError(
+        std::string_view err_msg,
+        std::pmr::memory_resource* res = std::pmr::get_default_resource()
+    ) : string_exception(err_msg, res) {};
+    ParseError(
+        const char* err_msg,
+        std::pmr::memory_resource* res = std::pmr::get_default_resource()
+    ) : string_exception(std::string_view(err_msg), res) {};
+    ParseError(std::pmr::string&& err_msg) : string_exception(std::move(err_msg)) {};
 };
 
 class SetupError : public string_exception {
     public :
-    SetupError(const std::string& err_msg) : string_exception(err_msg) {};
+    SetupError(
+        std::string_view err_msg,
+        std::pmr::memory_resource* res = std::pmr::get_default_resource()
+    ) : string_exception(err_msg, res) {};
+    SetupError(
+        const char* err_msg,
+        std::pmr::memory_resource* res = std::pmr::get_default_resource()
+    ) : string_exception(std::string_view(err_msg), res) {};
+    SetupError(std::pmr::string&& err_msg) : string_exception(std::move(err_msg)) {};
 };
 
 #endif
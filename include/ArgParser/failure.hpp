@@ -0,0 +1,253 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <charconv>
+#include <span>
+#include <limits>
+#ifndef STATIC_PARSER_NO_HEAP
+#include <string>
+#include <memory_resource>
+#endif
+
+#include "profiles.hpp"
+#include "suggest.hpp"
+
+namespace sp {
+namespace parser {
+
+/*
+ParseFailure is the non-throwing description of a failed parse.
+
+only codes, a token view and a profile pointer are recorded
+when the failure happens, text is produced on demand
+by format() / message(), so a failed try_parse costs
+no allocation and no unwinding
+*/
+
+enum class ParseErrc : std::uint8_t {
+    kNone = 0,
+    kEmptyToken,
+    kNotANumber,
+    kOutOfRange,
+    kPartialNumber,
+    kNotNullTerminated,
+    kUnknownTypeCode,
+    kUnknownFlag,
+    kInsufficientNarg,
+    kUnexpectedPosarg,
+    kRequiredMissing,
+    kResponseFileOpen,
+    kResponseFileDepth,
+    kResponseFileLimit,
+    kStreamRead,
+    kStreamOverflow,
+    kSubcommandSetup,
+    kFallbackSurplus,
+    kCallLimit,
+    kExcluded,
+    kNotABoolean,
+    kInvalidChoice,
+    kMapperSetup,
+    kFallbackNotABoolean
+};
+
+constexpr const char* errc_to_str(ParseErrc code) noexcept {
+    switch(code) {
+        case ParseErrc::kNone : return "No error";
+        case ParseErrc::kEmptyToken : return "Input token is empty";
+        case ParseErrc::kNotANumber : return "Input is not a number";
+        case ParseErrc::kOutOfRange : return "Input is out of range";
+        case ParseErrc::kPartialNumber : return "Input can't be fully converted to a number";
+        case ParseErrc::kNotNullTerminated : return "Token is not null-terminated";
+        case ParseErrc::kUnknownTypeCode : return "Unknown type code";
+        case ParseErrc::kUnknownFlag : return "Unknown flag was passed";
+        case ParseErrc::kInsufficientNarg : return "Insufficient narg";
+        case ParseErrc::kUnexpectedPosarg : return "Unexpected dump inputs";
+        case ParseErrc::kRequiredMissing : return "A required profile was not called";
+        case ParseErrc::kResponseFileOpen : return "Can't read response file";
+        case ParseErrc::kResponseFileDepth : return "Response files are nested too deep";
+        case ParseErrc::kResponseFileLimit : return "Too many response files";
+        case ParseErrc::kStreamRead : return "Can't read the token stream";
+        case ParseErrc::kStreamOverflow : return "Tokens of one option exceed the stream buffer";
+        case ParseErrc::kSubcommandSetup : return "Selected subcommand has invalid bindings";
+        case ParseErrc::kFallbackSurplus : return "Fallback value has more tokens than its profile takes";
+        case ParseErrc::kCallLimit : return "A profile was called more than its call limit";
+        case ParseErrc::kExcluded : return "Mutually exclusive profiles were called together";
+        case ParseErrc::kNotABoolean : return "Input is not a boolean word";
+        case ParseErrc::kInvalidChoice : return "Input is not one of the allowed choices";
+        case ParseErrc::kMapperSetup : return "RuntimeMapper has invalid bindings";
+        case ParseErrc::kFallbackNotABoolean : return "Fallback value of a flag is not a boolean word";
+    }
+    return "Unknown error";
+}
+
+struct ParseFailure {
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    ParseErrc code = ParseErrc::kNone;
+    std::size_t token_index = npos; // index in argv, npos when no token is involved
+    const profiles::static_profile* profile = nullptr;
+    std::string_view token{};
+    std::size_t detail = 0; // code dependent (e.g. missing narg count)
+    std::span<const suggest::Entry> known_names{}; // names of the Context with kUnknownFlag, allowed words with kInvalidChoice
+
+    constexpr explicit operator bool() const noexcept { return code != ParseErrc::kNone; }
+
+    constexpr ParseFailure& set(
+        ParseErrc new_code,
+        std::string_view new_token = {},
+        const profiles::static_profile* new_profile = nullptr
+    ) noexcept {
+        code = new_code;
+        token = new_token;
+        profile = new_profile;
+        return *this;
+    }
+
+    constexpr const char* describe() const noexcept { return errc_to_str(code); }
+
+    // closest known names of an unknown flag (or allowed words of a bad choice), computed on each call
+    constexpr suggest::Suggestions suggestions() const noexcept {
+        if((code != ParseErrc::kUnknownFlag) and (code != ParseErrc::kInvalidChoice)) return {};
+        return suggest::closest(known_names, token);
+    }
+
+    // AppendF is called with std::string_view pieces of the message
+    template <typename AppendF>
+    void write_message(const AppendF& append) const {
+        char num[24]{};
+        switch(code) {
+            case ParseErrc::kNotANumber :
+            case ParseErrc::kOutOfRange :
+                append("Input : "); append(token);
+                append((code == ParseErrc::kNotANumber) ? ", Is not a number" : ", Is out of range");
+                return;
+
+            case ParseErrc::kNotABoolean :
+                append("Input : "); append(token); append(", Is not a boolean (true|false|yes|no|on|off|1|0)");
+                return;
+
+            case ParseErrc::kPartialNumber :
+                append("Can't fully convert "); append(token); append(" To a number");
+                return;
+
+            case ParseErrc::kNotNullTerminated :
+                append("Token : "); append(token); append(" Is not null-terminated");
+                return;
+
+            case ParseErrc::kUnknownTypeCode :
+                append("Unknown type code of ");
+                append(profile ? values::type_code::code_to_str(profile->convert_code) : "<UNKNOWN_TCODE>");
+                return;
+
+            case ParseErrc::kUnknownFlag :
+            case ParseErrc::kInvalidChoice :
+            {
+                if(code == ParseErrc::kUnknownFlag) {
+                    append("Unknown flag was passed : "); append(token);
+                } else {
+                    append("Input : "); append(token); append(", Is not one of ");
+                    const std::span<const NameType> words = profile ? profile->choices.words : std::span<const NameType>{};
+                    for(std::size_t i = 0; i < words.size(); i++) {
+                        if(i) append("|");
+                        append(words[i]);
+                    }
+                    if(profile) { append(" for "); append(profiles::get_name(*profile)); }
+                }
+                const suggest::Suggestions hints = suggestions();
+                for(std::size_t i = 0; i < hints.size(); i++) {
+                    append((i == 0) ? ", did you mean " : (i + 1 == hints.size()) ? " or " : ", ");
+                    append(hints[i].name);
+                }
+                if(!hints.empty()) append(" ?");
+                return;
+            }
+
+            case ParseErrc::kInsufficientNarg :
+                append("Insufficient narg for "); append(profile ? profiles::get_name(*profile) : "?");
+                append(", still needs ");
+                append(std::string_view(num, std::to_chars(num, num + sizeof(num), detail).ptr - num));
+                return;
+
+            case ParseErrc::kUnexpectedPosarg :
+                append("Unexpected dump inputs of "); append(token);
+                return;
+
+            case ParseErrc::kRequiredMissing :
+                append("A required ");
+                append(!profile ? "option" : profile->is_posarg ? "posarg" : profile->is_subcommand() ? "subcommand" : "option");
+                append(" of \""); append(profile ? profiles::get_name(*profile) : "?"); append("\" was not called");
+                return;
+
+            case ParseErrc::kResponseFileOpen :
+            case ParseErrc::kResponseFileDepth :
+            case ParseErrc::kResponseFileLimit :
+                append(describe()); append(" : "); append(token);
+                return;
+
+            case ParseErrc::kCallLimit :
+                append(profile ? profiles::get_name(*profile) : "?"); append(" can't be called more than ");
+                append(std::string_view(num, std::to_chars(num, num + sizeof(num), detail).ptr - num));
+                append((detail == 1) ? " time" : " times");
+                return;
+
+            case ParseErrc::kExcluded :
+                append(profile ? profiles::get_name(*profile) : "?"); append(" can't be used with "); append(token);
+                return;
+
+            case ParseErrc::kFallbackSurplus :
+                append("Fallback value of "); append(profile ? profiles::get_name(*profile) : "?");
+                append(" has more tokens than it takes, from : "); append(token);
+                return;
+
+            case ParseErrc::kSubcommandSetup :
+                append("Subcommand \""); append(profile ? profiles::get_name(*profile) : "?");
+                append("\" has invalid bindings : "); append(token);
+                return;
+
+            case ParseErrc::kMapperSetup :
+                append("RuntimeMapper has invalid bindings : "); append(token);
+                return;
+
+            case ParseErrc::kFallbackNotABoolean :
+                append("Fallback value of "); append(profile ? profiles::get_name(*profile) : "?");
+                append(" is not a boolean (true|false|yes|no|on|off|1|0) : "); append(token);
+                return;
+
+            default :
+                append(describe());
+                return;
+        }
+    }
+
+    // writes a null-terminated (possibly truncated) message, returns the length written
+    std::size_t format(std::span<char> buff) const {
+        if(buff.empty()) return 0;
+        std::size_t len = 0;
+        write_message([&](std::string_view piece) {
+            std::size_t n = piece.size();
+            if(n > (buff.size() - 1 - len)) n = buff.size() - 1 - len;
+            piece.copy(buff.data() + len, n);
+            len += n;
+        });
+        buff[len] = '\0';
+        return len;
+    }
+
+    #ifndef STATIC_PARSER_NO_HEAP
+    std::string message() const {
+        std::string res;
+        write_message([&](std::string_view piece) { res.append(piece); });
+        return res;
+    }
+
+    std::pmr::string message(std::pmr::memory_resource* resource) const {
+        std::pmr::string res(resource);
+        write_message([&](std::string_view piece) { res.append(piece); });
+        return res;
+    }
+    #endif
+};
+
+}
+}
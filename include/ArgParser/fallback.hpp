@@ -0,0 +1,268 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <span>
+#include <vector>
+#include <algorithm>
+#include <string_view>
+#include <memory_resource>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mapper.hpp"
+#include "parser.hpp"
+
+// POSIX leaves its declaration to the program (glibc only has it with _GNU_SOURCE)
+extern char** environ;
+
+namespace sp {
+namespace parser {
+
+/*
+Environment / config file fallbacks
+
+a profile declares its keys with .env("JOBS_LIMIT") and
+.config("limit"), when the command line leaves it uncalled
+it takes the value found for them (the environment first),
+before the required check
+
+    static parser::Fallbacks fallbacks("/etc/jobs.conf");
+    fallbacks.attach(rctx.mapper);
+    parse(rctx.mapper, argv, argc);
+
+the config file is mmap'd once (MAP_PRIVATE) and indexed :
+one "key = value" per line, whole-line '#' comments, a value is
+split on whitespace into NUL terminated tokens in place.
+a missing or unreadable file is no config (see config_loaded()).
+the value of a flag is a boolean word (see apply_fallbacks).
+
+attach() indexes the env / config values of a Context once,
+environ is scanned a single time for it, the values are copied
+(a snapshot, later setenv() calls aren't seen). every RuntimeMapper
+of the same Context attached afterwards reuses that index, and
+every parse only walks the profiles having a value.
+
+attach() isn't thread safe, attach at setup, parses only read
+the index. Fallbacks must outlive the attached mappers
+and the StrT values taken from it
+*/
+
+class Fallbacks {
+    private :
+    struct ConfigPair {
+        std::string_view key{};
+        std::string_view tokens{};
+    };
+
+    struct Entry {
+        const void* mapper = nullptr;
+        std::span<const mapper::FallbackValue> values{};
+    };
+
+    struct Wanted {
+        std::string_view key{};
+        std::size_t slot = 0;
+    };
+
+    std::pmr::monotonic_buffer_resource arena;
+    std::pmr::vector<ConfigPair> config{&arena};
+    std::pmr::vector<Entry> entries{&arena};
+    void* map_addr = nullptr;
+    std::size_t map_size = 0;
+    bool loaded = false;
+    int load_errno = 0;
+    std::size_t skipped = 0;
+
+    static constexpr bool is_space(char c) noexcept {
+        return (c == ' ') or (c == '\t') or (c == '\r') or (c == '\v') or (c == '\f');
+    }
+
+    static constexpr bool is_blank_or_nul(char c) noexcept {
+        return is_space(c) or (c == '\0');
+    }
+
+    // NUL terminated tokens of [begin, end) in a new arena string
+    std::string_view copy_tokens(const char* begin, const char* end) {
+        const std::size_t len = end - begin;
+        char* copy = static_cast<char*>(arena.allocate(len + 1, alignof(char)));
+        for(std::size_t i = 0; i < len; i++) copy[i] = is_space(begin[i]) ? '\0' : begin[i];
+        copy[len] = '\0';
+        return std::string_view(copy, len);
+    }
+
+    void load(const char* path) {
+        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if(fd < 0) {
+            load_errno = errno;
+            return;
+        }
+
+        struct stat st{};
+        if(::fstat(fd, &st) != 0) {
+            load_errno = errno;
+            ::close(fd);
+            return;
+        }
+
+        map_size = static_cast<std::size_t>(st.st_size);
+        if(map_size) {
+            map_addr = ::mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if(map_addr == MAP_FAILED) {
+                load_errno = errno;
+                map_addr = nullptr;
+                map_size = 0;
+                ::close(fd);
+                return;
+            }
+            ::madvise(map_addr, map_size, MADV_SEQUENTIAL);
+        }
+        ::close(fd);
+        loaded = true;
+
+        char* curr = static_cast<char*>(map_addr);
+        char* const end = curr + map_size;
+        while(curr != end) {
+            char* line_end = static_cast<char*>(std::memchr(curr, '\n', end - curr));
+            if(!line_end) line_end = end;
+            index_line(curr, line_end, end);
+            curr = (line_end == end) ? end : (line_end + 1);
+        }
+
+        // the last occurrence of a key wins, stable_sort keeps them in file order
+        std::stable_sort(config.begin(), config.end(), [](const ConfigPair& a, const ConfigPair& b) { return a.key < b.key; });
+    }
+
+    void index_line(char* begin, char* line_end, char* map_end) {
+        while((begin != line_end) and is_space(*begin)) ++begin;
+        if((begin == line_end) or (*begin == '#')) return;
+
+        char* eq = static_cast<char*>(std::memchr(begin, '=', line_end - begin));
+        if(!eq) {
+            ++skipped;
+            return;
+        }
+
+        char* key_end = eq;
+        while((key_end != begin) and is_space(key_end[-1])) --key_end;
+        char* value = eq + 1;
+        while((value != line_end) and is_space(*value)) ++value;
+        char* value_end = line_end;
+        while((value_end != value) and is_space(value_end[-1])) --value_end;
+        if(key_end == begin) {
+            ++skipped;
+            return;
+        }
+        if(value == value_end) return; // "key =" gives no value
+
+        std::string_view tokens;
+        if(value_end != map_end) {
+            for(char* c = value; c != value_end; c++) {
+                if(is_space(*c)) *c = '\0';
+            }
+            *value_end = '\0';
+            tokens = std::string_view(value, value_end - value);
+        } else {
+            tokens = copy_tokens(value, value_end); // no byte left for its NUL
+        }
+        config.push_back(ConfigPair{ std::string_view(begin, key_end - begin), tokens });
+    }
+
+    std::string_view config_value(std::string_view key) const noexcept {
+        auto it = std::upper_bound(config.begin(), config.end(), key, [](std::string_view k, const ConfigPair& pair) { return k < pair.key; });
+        if((it == config.begin()) or ((it - 1)->key != key)) return {};
+        return (it - 1)->tokens;
+    }
+
+    // tokens of an environment / config value without any token are no value
+    static bool has_token(std::string_view tokens) noexcept {
+        return std::any_of(tokens.begin(), tokens.end(), [](char c) { return !is_blank_or_nul(c); });
+    }
+
+    template <std::size_t IDCount>
+    std::span<const mapper::FallbackValue> build(const mapper::Mapper<IDCount>& smapper) {
+        std::pmr::vector<mapper::FallbackValue> found(&arena);
+        std::pmr::vector<Wanted> wanted(&arena);
+
+        for(std::size_t i = 0; i < smapper.profiles.size(); i++) {
+            const profiles::static_profile& prof = smapper.profiles[i];
+            if(!prof.env_key and !prof.config_key) continue;
+            if(prof.env_key) wanted.push_back(Wanted{ prof.env_key, found.size() });
+            found.push_back(mapper::FallbackValue{ i, {} });
+        }
+        if(found.empty()) return {};
+
+        std::sort(wanted.begin(), wanted.end(), [](const Wanted& a, const Wanted& b) { return a.key < b.key; });
+        for(char** env = environ; env and *env; env++) {
+            std::string_view var(*env);
+            const std::size_t eq = var.find('=');
+            if(eq == std::string_view::npos) continue;
+            const std::string_view key = var.substr(0, eq);
+            const std::string_view val = var.substr(eq + 1);
+            if(!has_token(val)) continue;
+
+            auto it = std::lower_bound(wanted.begin(), wanted.end(), key, [](const Wanted& w, std::string_view k) { return w.key < k; });
+            for(; (it != wanted.end()) and (it->key == key); it++)
+                found[it->slot].tokens = copy_tokens(val.data(), val.data() + val.size());
+        }
+
+        for(mapper::FallbackValue& value : found) {
+            const profiles::static_profile& prof = smapper.profiles[value.index];
+            if(value.tokens.empty() and prof.config_key) value.tokens = config_value(prof.config_key);
+        }
+
+        found.erase(
+            std::remove_if(found.begin(), found.end(), [](const mapper::FallbackValue& value) { return value.tokens.empty(); }),
+            found.end()
+        );
+        mapper::FallbackValue* stored = static_cast<mapper::FallbackValue*>(
+            arena.allocate(found.size() * sizeof(mapper::FallbackValue), alignof(mapper::FallbackValue))
+        );
+        std::uninitialized_copy(found.begin(), found.end(), stored);
+        return std::span<const mapper::FallbackValue>(stored, found.size());
+    }
+
+    public :
+    // config_path may be nullptr (environment only)
+    explicit Fallbacks(
+        const char* config_path = nullptr,
+        std::pmr::memory_resource* resource = default_resource()
+    ) : arena(resource)
+    {
+        if(config_path) load(config_path);
+    }
+
+    Fallbacks(const Fallbacks&) = delete;
+    Fallbacks& operator=(const Fallbacks&) = delete;
+
+    ~Fallbacks() {
+        if(map_addr) ::munmap(map_addr, map_size);
+    }
+
+    // the values of smapper's profiles, indexed on the first call for this Mapper
+    template <std::size_t IDCount>
+    std::span<const mapper::FallbackValue> index(const mapper::Mapper<IDCount>& smapper) {
+        for(const Entry& entry : entries) {
+            if(entry.mapper == &smapper) return entry.values;
+        }
+        std::span<const mapper::FallbackValue> values = build(smapper);
+        entries.push_back(Entry{ &smapper, values });
+        return values;
+    }
+
+    template <std::size_t IDCount>
+    void attach(mapper::RuntimeMapper<IDCount>& rmap) {
+        rmap.set_fallbacks(index(rmap.mapper));
+    }
+
+    bool config_loaded() const noexcept { return loaded; }
+    int config_errno() const noexcept { return load_errno; } // errno of a failed load, 0 otherwise
+    std::size_t skipped_lines() const noexcept { return skipped; } // config lines without a key or '='
+    std::string_view config_value_of(std::string_view key) const noexcept { return config_value(key); }
+};
+
+}
+}
@@ -0,0 +1,223 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+#include "commons.hpp"
+#include "mapper.hpp"
+#include "parser.hpp"
+#include "small_buffer.hpp"
+
+namespace sp {
+namespace incremental {
+
+/*
+Incremental validation
+
+a Validator checks a command line being edited (a shell
+highlighting bad flags on every keystroke) against a Context,
+resuming from the last checkpoint the edit left untouched,
+an update costs about the edited tail, not the whole line :
+
+    incremental::Validator<IDs> check(rctx.mapper);
+    ...
+    // first_changed : index of the first token that differs from the previous update
+    ParseFailure fail = check.update(argv, argc, first_changed);
+    if(fail) highlight(fail.token_index, fail.describe());
+
+- a checkpoint is taken before every item of the option pass
+  (an option with its values, a positional token) : its token
+  index, the positional count and the size of an undo trail.
+  the trail gets the state of a profile (call count, called
+  bit, value cursor) from the mapper's Journal before it changes
+- an update rewinds the trail to the last checkpoint whose token
+  is before first_changed and runs the option pass from there
+- the positional pass, the fallbacks and the constraint check run
+  again on every update, over the positional tokens / fallbacks only
+- callbacks never run (immediate ones neither), a selected
+  subcommand isn't entered, its tokens start past subcommand_at()
+- when the checkpoints are full every other one is dropped, the
+  recent ones stay dense. a full trail makes the next update
+  a complete parse
+
+the profile states, the called set and the sizes of DynamicArr /
+Lazy bindings are those of a full parse, a scalar or a span the
+dropped tail wrote keeps that value until it's written again.
+
+the unchanged tokens must keep their storage between updates
+(kStr and Lazy values point there). the RuntimeMapper is the
+Validator's while it's attached, its resource must outlive
+it (the positional index may spill there)
+*/
+
+template <std::size_t IDCount, std::size_t MaxCheckpoints = 64, std::size_t MaxTrail = 256>
+class Validator {
+    static_assert(MaxCheckpoints >= 2, "Validator needs two checkpoints");
+    static_assert(MaxTrail > 0, "Validator needs an undo trail");
+
+    public :
+    static constexpr std::size_t npos = parser::ParseFailure::npos;
+
+    private :
+    struct Checkpoint {
+        std::uint32_t token = 0;        // index of the token starting the item
+        std::uint32_t trail = 0;        // trail size before it
+        std::uint32_t positional = 0;   // positional tokens stored before it
+        bool stored_any = false;
+    };
+
+    // state of a profile before the parse changed it
+    struct Undo {
+        std::uint32_t index = 0;
+        bool was_marked = false;
+        bool is_called = false;
+        WholeNumT call_count = 0;
+        WholeNumT fulfilled_args = 0;
+        std::size_t cursor = 0;
+    };
+
+    mapper::RuntimeMapper<IDCount>& rmap;
+    Checkpoint checkpoints[MaxCheckpoints]{};
+    std::size_t checkpoint_count = 0;
+    Undo trail[MaxTrail]{};
+    std::size_t trail_size = 0;
+    bool trail_lost = true; // nothing to resume from
+    utils::SmallBuffer<std::uint32_t, parser::kInlinePositional> positional;
+    std::size_t sub_token = npos;
+
+    static void note(void* owner, std::size_t idx) noexcept {
+        static_cast<Validator*>(owner)->record(idx);
+    }
+
+    void record(std::size_t idx) noexcept {
+        if(trail_lost) return;
+        if(trail_size == MaxTrail) {
+            trail_lost = true;
+            return;
+        }
+        const profiles::modifiable_profile& mprof = *rmap[idx].second;
+        trail[trail_size++] = Undo{
+            static_cast<std::uint32_t>(idx), rmap.called_set().test(idx),
+            mprof.is_called, mprof.call_count, mprof.fulfilled_args, mprof.bval.mark()
+        };
+    }
+
+    // latest entries first, the oldest one of a profile is its state at size
+    void undo_to(std::size_t size) noexcept {
+        while(trail_size > size) {
+            const Undo& undo = trail[--trail_size];
+            profiles::modifiable_profile& mprof = *rmap[undo.index].second;
+            mprof.is_called = undo.is_called;
+            mprof.call_count = undo.call_count;
+            mprof.fulfilled_args = undo.fulfilled_args;
+            mprof.bval.rewind(undo.cursor);
+            if(!undo.was_marked) rmap.unmark_called(undo.index);
+        }
+    }
+
+    void restart() {
+        rmap.reset();
+        trail_size = 0;
+        checkpoint_count = 0;
+        positional.clear();
+        trail_lost = false;
+    }
+
+    // drops every other checkpoint, the latest is kept
+    void thin() noexcept {
+        std::size_t kept = 0;
+        for(std::size_t i = (checkpoint_count % 2) ? 0 : 1; i < checkpoint_count; i += 2)
+            checkpoints[kept++] = checkpoints[i];
+        checkpoint_count = kept;
+    }
+
+    void checkpoint(std::size_t token, bool stored_any) noexcept {
+        if(trail_lost) return;
+        if(checkpoint_count == MaxCheckpoints) thin();
+        checkpoints[checkpoint_count++] = Checkpoint{
+            static_cast<std::uint32_t>(token), static_cast<std::uint32_t>(trail_size),
+            static_cast<std::uint32_t>(positional.size()), stored_any
+        };
+    }
+
+    // rewinds to the last checkpoint before first_changed, {its token, stored_any} ({0, false} from scratch)
+    std::pair<std::size_t, bool> rewind(std::size_t first_changed) {
+        while(checkpoint_count and (checkpoints[checkpoint_count - 1].token >= first_changed)) --checkpoint_count;
+        if(trail_lost or !checkpoint_count) {
+            restart();
+            return { 0, false };
+        }
+        // taken again when the option pass goes through its token
+        const Checkpoint cp = checkpoints[--checkpoint_count];
+        undo_to(cp.trail);
+        positional.truncate(cp.positional);
+        return { cp.token, cp.stored_any };
+    }
+
+    public :
+    explicit Validator(mapper::RuntimeMapper<IDCount>& runtime)
+        : rmap(runtime), positional(runtime.get_resource())
+    {
+        if(!rmap.verified()) rmap.verify();
+        rmap.set_journal(mapper::Journal{ this, &Validator::note });
+    }
+
+    Validator(const Validator&) = delete;
+    Validator& operator=(const Validator&) = delete;
+
+    ~Validator() { rmap.set_journal(mapper::Journal{}); }
+
+    /*
+    validates argv, first_changed is the index of the first token
+    not the same as in the previous update (the previous argc when
+    tokens were only appended, 0 for another line)
+    */
+    parser::ParseFailure update(const char** argv, int argc, std::size_t first_changed) {
+        const std::size_t count = (argc > 0) ? static_cast<std::size_t>(argc) : 0;
+        const std::pair<std::size_t, bool> from = rewind(first_changed);
+        std::size_t arg_i = from.first;
+        sub_token = npos;
+
+        auto get = [&]() {
+            if(arg_i >= count) return std::string_view{};
+            return std::string_view(argv[arg_i++]);
+        };
+
+        parser::ParseFailure fail{};
+        mapper::FindPair selected = parser::option_pass(
+            rmap, get(), from.second, get,
+            [&](const std::string_view&) { positional.push_back(static_cast<std::uint32_t>(arg_i - 1)); },
+            [](mapper::FindPair&) {},
+            [&](bool stored) { checkpoint(arg_i - 1, stored); },
+            fail, instrument::null_instrument
+        );
+        if(selected.first) sub_token = arg_i - 1;
+
+        std::size_t pos_i = 0;
+        if(!fail) parser::handle_posarg(
+            [&]() {
+                if(pos_i == positional.size()) return std::string_view{};
+                return std::string_view(argv[positional[pos_i++]]);
+            },
+            rmap, fail
+        );
+        if(!fail and !rmap.get_fallbacks().empty()) parser::apply_fallbacks(rmap, fail);
+        if(!fail) parser::check_constraints(rmap, fail);
+
+        if(fail) fail.token_index = parser::token_index_of(argv, argc, fail.token);
+        return fail;
+    }
+
+    // validates another line from scratch
+    parser::ParseFailure update(const char** argv, int argc) { return update(argv, argc, 0); }
+
+    // index of the token naming the selected subcommand, npos if none
+    std::size_t subcommand_at() const noexcept { return sub_token; }
+
+    // false once the trail ran out, the next update parses the whole line
+    bool resumable() const noexcept { return !trail_lost; }
+};
+
+}
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace sp {
+namespace utils {
+
+/*
+InlineFunction is a fixed-size, never allocating
+replacement of std::function.
+
+the callable is stored inside the object itself,
+a callable bigger than Capacity is a compile error
+instead of a silent heap allocation, so it's usable
+with STATIC_PARSER_NO_HEAP too.
+
+calling an empty InlineFunction does nothing
+(return type must then be default constructible)
+*/
+
+template <typename Signature, std::size_t Capacity = 4 * sizeof(void*)>
+class InlineFunction;
+
+template <typename Ret, typename... Args, std::size_t Capacity>
+class InlineFunction<Ret(Args...), Capacity> {
+    private :
+    enum class Op { kCopy, kDestroy };
+
+    using InvokeF = Ret(*)(void*, Args...);
+    using ManageF = void(*)(Op, void* self, const void* oth);
+
+    alignas(std::max_align_t) unsigned char storage[Capacity];
+    InvokeF invoker = nullptr;
+    ManageF manager = nullptr;
+
+    template <typename F>
+    static Ret invoke_impl(void* obj, Args... args) {
+        return (*static_cast<F*>(obj))(std::forward<Args>(args)...);
+    }
+
+    template <typename F>
+    static void manage_impl(Op op, void* self, const void* oth) {
+        if(op == Op::kCopy)
+            ::new (self) F(*static_cast<const F*>(oth));
+        else
+            static_cast<F*>(self)->~F();
+    }
+
+    void copy_from(const InlineFunction& oth) {
+        if(oth.manager) oth.manager(Op::kCopy, storage, oth.storage);
+        else std::memcpy(storage, oth.storage, Capacity);
+        invoker = oth.invoker;
+        manager = oth.manager;
+    }
+
+    public :
+    InlineFunction() noexcept = default;
+    InlineFunction(std::nullptr_t) noexcept {}
+
+    template <
+        typename F,
+        typename = std::enable_if_t<
+            !std::is_same_v<std::decay_t<F>, InlineFunction> &&
+            std::is_invocable_r_v<Ret, std::decay_t<F>&, Args...>
+        >
+    >
+    InlineFunction(F&& func) {
+        using Fn = std::decay_t<F>;
+        static_assert(sizeof(Fn) <= Capacity, "Callable doesn't fit in InlineFunction Capacity");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t), "Callable is over-aligned for InlineFunction");
+        static_assert(std::is_copy_constructible_v<Fn>, "InlineFunction requires a copyable callable");
+
+        ::new (static_cast<void*>(storage)) Fn(std::forward<F>(func));
+        invoker = &invoke_impl<Fn>;
+        if constexpr (!std::is_trivially_copyable_v<Fn> || !std::is_trivially_destructible_v<Fn>)
+            manager = &manage_impl<Fn>;
+        else
+            manager = nullptr;
+    }
+
+    InlineFunction(const InlineFunction& oth) { copy_from(oth); }
+
+    InlineFunction& operator=(const InlineFunction& oth) {
+        if(this != &oth) {
+            reset();
+            copy_from(oth);
+        }
+        return *this;
+    }
+
+    ~InlineFunction() { reset(); }
+
+    void reset() noexcept {
+        if(manager) manager(Op::kDestroy, storage, nullptr);
+        invoker = nullptr;
+        manager = nullptr;
+    }
+
+    explicit operator bool() const noexcept { return invoker != nullptr; }
+
+    Ret operator()(Args... args) const {
+        if(!invoker) {
+            if constexpr (std::is_void_v<Ret>) return;
+            else return Ret{};
+        }
+        return invoker(const_cast<unsigned char*>(storage), std::forward<Args>(args)...);
+    }
+};
+
+}
+}
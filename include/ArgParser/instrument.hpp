@@ -0,0 +1,293 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <span>
+#include <chrono>
+#include <charconv>
+#include <string_view>
+#include <concepts>
+#include <type_traits>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "commons.hpp"
+#include "values_experiment.hpp"
+
+namespace sp {
+namespace instrument {
+
+/*
+Parse instrumentation
+
+the parse functions take an instrumentation policy by reference,
+by default NoInstrument whose hooks are empty inline functions,
+so an uninstrumented parse compiles to the same code as before.
+
+    instrument::CountingInstrument instr;
+    parser::run_parse(rctx.mapper, argv, argc, instr);
+    instr.counters.format_json(buff);
+
+phases are timed in cycles (rdtsc / cntvct, steady_clock ns
+elsewhere), kFetch is nested inside kOptions, kPosargs and kFallbacks,
+every other phase is disjoint
+*/
+
+enum class Phase : std::uint8_t {
+    kOptions = 0,  // handle_opt
+    kPosargs,      // handle_posarg
+    kRequired,     // constraint check (required, exclusions)
+    kCallbacks,    // callback loop after the parse
+    kFetch,        // fetch_and_next, nested
+    kFallbacks,    // environment / config fallback values
+    kCount
+};
+
+constexpr std::size_t kPhaseCount = static_cast<std::size_t>(Phase::kCount);
+
+constexpr const char* phase_to_str(Phase phase) noexcept {
+    switch(phase) {
+        case Phase::kOptions : return "options";
+        case Phase::kPosargs : return "posargs";
+        case Phase::kRequired : return "required";
+        case Phase::kCallbacks : return "callbacks";
+        case Phase::kFetch : return "fetch";
+        case Phase::kFallbacks : return "fallbacks";
+        default : return "unknown";
+    }
+}
+
+// conversion counters are kept per converted type
+enum class ConvSlot : std::uint8_t { kInt = 0, kDob, kStr, kI64, kU64, kFlt, kBool, kChoice, kOther, kCount };
+
+constexpr std::size_t kConvSlotCount = static_cast<std::size_t>(ConvSlot::kCount);
+
+constexpr const char* conv_slot_to_str(ConvSlot slot) noexcept {
+    switch(slot) {
+        case ConvSlot::kInt : return "int";
+        case ConvSlot::kDob : return "dob";
+        case ConvSlot::kStr : return "str";
+        case ConvSlot::kI64 : return "i64";
+        case ConvSlot::kU64 : return "u64";
+        case ConvSlot::kFlt : return "flt";
+        case ConvSlot::kBool : return "bool";
+        case ConvSlot::kChoice : return "choice";
+        default : return "other";
+    }
+}
+
+constexpr ConvSlot conv_slot_of(const TypeCodeT& code) noexcept {
+    if(code == values::type_code::kInt) return ConvSlot::kInt;
+    if(code == values::type_code::kDob) return ConvSlot::kDob;
+    if(code == values::type_code::kStr) return ConvSlot::kStr;
+    if(code == values::type_code::kI64) return ConvSlot::kI64;
+    if(code == values::type_code::kU64) return ConvSlot::kU64;
+    if(code == values::type_code::kFlt) return ConvSlot::kFlt;
+    if(code == values::type_code::kBool) return ConvSlot::kBool;
+    if(code == values::type_code::kChoice) return ConvSlot::kChoice;
+    return ConvSlot::kOther;
+}
+
+inline std::uint64_t read_cycles() noexcept {
+    #if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+    #elif defined(__aarch64__)
+    std::uint64_t val;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(val));
+    return val;
+    #else
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count()
+    );
+    #endif
+}
+
+template <typename T>
+concept Instrument = requires(T& instr, Phase phase, const TypeCodeT& code, bool found) {
+    instr.phase_begin(phase);
+    instr.phase_end(phase);
+    instr.on_token();
+    instr.on_lookup(found);
+    instr.on_convert(code);
+    instr.callback_begin();
+    instr.callback_end();
+};
+
+struct NoInstrument {
+    static constexpr bool enabled = false;
+    void phase_begin(Phase) noexcept {}
+    void phase_end(Phase) noexcept {}
+    void on_token() noexcept {}
+    void on_lookup(bool) noexcept {}
+    void on_convert(const TypeCodeT&) noexcept {}
+    void callback_begin() noexcept {}
+    void callback_end() noexcept {}
+};
+
+// default argument of the parse functions, stateless
+inline NoInstrument null_instrument{};
+
+/*
+InstrumentRef is a nullable, type erased reference to an instrument,
+for the parses whose instrument can't be a template parameter
+(a subcommand's parse runs behind a function pointer).
+an empty InstrumentRef ignores every hook
+*/
+class InstrumentRef {
+    private :
+    struct Hooks {
+        void (*phase_begin)(void*, Phase);
+        void (*phase_end)(void*, Phase);
+        void (*on_token)(void*);
+        void (*on_lookup)(void*, bool);
+        void (*on_convert)(void*, const TypeCodeT&);
+        void (*callback_begin)(void*);
+        void (*callback_end)(void*);
+    };
+
+    template <typename Instr>
+    static constexpr Hooks hooks_of {
+        [](void* obj, Phase phase) { static_cast<Instr*>(obj)->phase_begin(phase); },
+        [](void* obj, Phase phase) { static_cast<Instr*>(obj)->phase_end(phase); },
+        [](void* obj) { static_cast<Instr*>(obj)->on_token(); },
+        [](void* obj, bool found) { static_cast<Instr*>(obj)->on_lookup(found); },
+        [](void* obj, const TypeCodeT& code) { static_cast<Instr*>(obj)->on_convert(code); },
+        [](void* obj) { static_cast<Instr*>(obj)->callback_begin(); },
+        [](void* obj) { static_cast<Instr*>(obj)->callback_end(); }
+    };
+
+    void* obj = nullptr;
+    const Hooks* hooks = nullptr;
+
+    public :
+    static constexpr bool enabled = true;
+
+    InstrumentRef() noexcept = default;
+
+    template <Instrument Instr>
+    requires (!std::is_same_v<Instr, InstrumentRef>)
+    explicit InstrumentRef(Instr& instr) noexcept : obj(&instr), hooks(&hooks_of<Instr>) {}
+
+    // NoInstrument gives an empty reference, an InstrumentRef is copied
+    template <Instrument Instr>
+    static InstrumentRef of(Instr& instr) noexcept {
+        if constexpr (std::is_same_v<Instr, NoInstrument>) return InstrumentRef{};
+        else if constexpr (std::is_same_v<Instr, InstrumentRef>) return instr;
+        else return InstrumentRef(instr);
+    }
+
+    explicit operator bool() const noexcept { return hooks != nullptr; }
+
+    void phase_begin(Phase phase) noexcept { if(hooks) hooks->phase_begin(obj, phase); }
+    void phase_end(Phase phase) noexcept { if(hooks) hooks->phase_end(obj, phase); }
+    void on_token() noexcept { if(hooks) hooks->on_token(obj); }
+    void on_lookup(bool found) noexcept { if(hooks) hooks->on_lookup(obj, found); }
+    void on_convert(const TypeCodeT& code) noexcept { if(hooks) hooks->on_convert(obj, code); }
+    void callback_begin() noexcept { if(hooks) hooks->callback_begin(obj); }
+    void callback_end() noexcept { if(hooks) hooks->callback_end(obj); }
+};
+
+struct ParseCounters {
+    std::array<std::uint64_t, kPhaseCount> phase_calls{};
+    std::array<std::uint64_t, kPhaseCount> phase_cycles{};
+    std::array<std::uint64_t, kConvSlotCount> conversions{};
+    std::uint64_t tokens = 0;
+    std::uint64_t lookups = 0;
+    std::uint64_t lookup_misses = 0;
+    std::uint64_t callbacks = 0;
+    std::uint64_t callback_cycles = 0;
+
+    void clear() noexcept { *this = ParseCounters{}; }
+
+    // AppendF is called with std::string_view pieces of one JSON object
+    template <typename AppendF>
+    void write_json(const AppendF& append) const {
+        char num[24]{};
+        auto number = [&](std::uint64_t val) {
+            append(std::string_view(num, std::to_chars(num, num + sizeof(num), val).ptr - num));
+        };
+        auto field = [&](std::string_view key, std::uint64_t val, bool comma) {
+            append("\""); append(key); append("\":"); number(val);
+            if(comma) append(",");
+        };
+
+        append("{\"phases\":{");
+        for(std::size_t i = 0; i < kPhaseCount; i++) {
+            append("\""); append(phase_to_str(static_cast<Phase>(i))); append("\":{");
+            field("calls", phase_calls[i], true);
+            field("cycles", phase_cycles[i], false);
+            append((i + 1 < kPhaseCount) ? "}," : "}");
+        }
+        append("},\"conversions\":{");
+        for(std::size_t i = 0; i < kConvSlotCount; i++)
+            field(conv_slot_to_str(static_cast<ConvSlot>(i)), conversions[i], (i + 1 < kConvSlotCount));
+        append("},");
+        field("tokens", tokens, true);
+        field("lookups", lookups, true);
+        field("lookup_misses", lookup_misses, true);
+        field("callbacks", callbacks, true);
+        field("callback_cycles", callback_cycles, false);
+        append("}");
+    }
+
+    // writes a null-terminated (possibly truncated) JSON object, returns the length written
+    std::size_t format_json(std::span<char> buff) const {
+        if(buff.empty()) return 0;
+        std::size_t len = 0;
+        write_json([&](std::string_view piece) {
+            std::size_t n = piece.size();
+            if(n > (buff.size() - 1 - len)) n = buff.size() - 1 - len;
+            piece.copy(buff.data() + len, n);
+            len += n;
+        });
+        buff[len] = '\0';
+        return len;
+    }
+};
+
+/*
+CountingInstrument accumulates over every parse it's given to,
+counters.clear() starts over. not thread safe, use one per thread
+*/
+struct CountingInstrument {
+    static constexpr bool enabled = true;
+    ParseCounters counters{};
+
+    private :
+    std::array<std::uint64_t, kPhaseCount> started{};
+    std::uint64_t callback_started = 0;
+
+    public :
+    void phase_begin(Phase phase) noexcept {
+        started[static_cast<std::size_t>(phase)] = read_cycles();
+    }
+
+    void phase_end(Phase phase) noexcept {
+        const std::size_t i = static_cast<std::size_t>(phase);
+        counters.phase_cycles[i] += read_cycles() - started[i];
+        ++counters.phase_calls[i];
+    }
+
+    void on_token() noexcept { ++counters.tokens; }
+
+    void on_lookup(bool found) noexcept {
+        ++counters.lookups;
+        if(!found) ++counters.lookup_misses;
+    }
+
+    void on_convert(const TypeCodeT& code) noexcept {
+        ++counters.conversions[static_cast<std::size_t>(conv_slot_of(code))];
+    }
+
+    void callback_begin() noexcept { callback_started = read_cycles(); }
+
+    void callback_end() noexcept {
+        counters.callback_cycles += read_cycles() - callback_started;
+        ++counters.callbacks;
+    }
+};
+
+}
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#include "commons.hpp"
+#include "exceptions.hpp"
+#include "values_experiment.hpp"
+#include "failure.hpp"
+#include "numeric.hpp"
+
+namespace sp {
+namespace values {
+
+/*
+Lazily converted values
+
+binding a kInt / kDob profile to a Lazy instead of a variable
+makes the parser record its token views only, a value the
+program never reads on a given run is never converted :
+
+    values::Lazy<IntT, 3> layout;     // --dump-layout 1 2 3
+    mprofs[i].bind(layout);
+    ...
+    if(debug) for(IntT v : layout.values()) ...
+
+at parse time a token only gets parser::check_number_syntax,
+"--dump-layout x" still fails the parse (kNotANumber), what it
+can't see (out of range, "1e+") comes out of the conversion :
+convert() returns it, the accessors throw a ParseError.
+
+the tokens are converted once, on the first read after a parse,
+the values are cached until the next token is recorded / reset.
+reads aren't thread safe (the cache is filled on a const access).
+the tokens must outlive the reads (see LazyTokens)
+*/
+
+template <typename T, std::size_t N = 1>
+class Lazy : public LazyTokens {
+    static_assert(std::is_same_v<T, IntT> or std::is_same_v<T, DobT>, "Lazy only holds IntT or DobT values");
+    static_assert(N > 0, "Lazy needs a slot");
+
+    private :
+    std::string_view storage[N]{};
+    mutable T cache[N]{};
+    mutable parser::ParseErrc error = parser::ParseErrc::kNone;
+    mutable std::size_t error_at = 0;
+
+    static constexpr type_code::Tcode code_of() noexcept {
+        return std::is_same_v<T, IntT> ? type_code::kInt : type_code::kDob;
+    }
+
+    public :
+    using value_type = T;
+    static constexpr std::size_t slot_count = N;
+
+    Lazy() noexcept : LazyTokens(storage, N, code_of()) {}
+
+    // converts the recorded tokens if they aren't yet, the error of the first failing one (kNone if none)
+    parser::ParseErrc convert() const noexcept {
+        if(converted) return error;
+        error = parser::ParseErrc::kNone;
+        const std::span<const std::string_view> toks = tokens();
+        for(std::size_t i = 0; i < toks.size(); i++) {
+            const parser::ParseErrc ec = parser::convert_number(toks[i], cache[i]);
+            if((ec != parser::ParseErrc::kNone) and (error == parser::ParseErrc::kNone)) {
+                error = ec;
+                error_at = i;
+            }
+        }
+        converted = true;
+        return error;
+    }
+
+    // the token convert() failed on, empty when it didn't
+    std::string_view failed_token() const noexcept {
+        return (convert() == parser::ParseErrc::kNone) ? std::string_view{} : tokens()[error_at];
+    }
+
+    bool has_value() const noexcept { return size() != 0; }
+
+    std::span<const T> values() const {
+        if(const parser::ParseErrc ec = convert(); ec != parser::ParseErrc::kNone)
+            throw except::ParseError(parser::errc_to_str(ec));
+        return std::span<const T>(cache, size());
+    }
+
+    const T& operator[](std::size_t i) const {
+        if(i >= size())
+            throw except::ParseError("Lazy : value index out of recorded values");
+        return values()[i];
+    }
+
+    const T& get() const { return (*this)[0]; }
+
+    // the first value, or fallback when the profile got none
+    T value_or(const T& fallback) const { return has_value() ? get() : fallback; }
+};
+
+using LazyInt = Lazy<IntT>;
+using LazyDob = Lazy<DobT>;
+
+}
+}
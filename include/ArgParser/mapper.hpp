@@ -3,13 +3,16 @@
 #include <array>
 #include <span>
 #include <utility>
-#include <frozen/unordered_map.h>
-#include <frozen/string.h>
+#include <string_view>
 #include <type_traits>
+#include <memory_resource>
 
 #include "commons.hpp"
 #include "exceptions.hpp"
 #include "profiles.hpp"
+#include "dispatch.hpp"
+#include "suggest.hpp"
+#include "constraint.hpp"
 
 namespace sp {
 
@@ -66,16 +69,22 @@ struct PosargIndex {
     PosargIndex(std::size_t i) : val(i) {}
 };
 
+// 'v' of "-v"
+struct ShortName {
+    char val = '\0';
+    ShortName(char c) : val(c) {}
+};
+
 template <std::size_t IDCount>
 class Mapper {
     private :
-    using MapType = frozen::unordered_map<frozen::string, const profiles::static_profile*, IDCount>;
+    using DispatchType = dispatch::NameDispatcher<IDCount>;
     
     constexpr void verify_relation(const profiles::static_profile* target, profiles::NameType name) {
-        auto it = map.find(frozen::string(name));
-        if(it == map.end()) 
+        dispatch::IndexT idx = dispatcher.find(name);
+        if(idx == dispatch::npos) 
             throw except::comtime_except("Unknown profile name in map (Forget to register ?)");
-        if(it->second != target)
+        if(&profiles[idx] != target)
             throw except::comtime_except("Name in map, points to the wrong profile");
     }
 
@@ -83,22 +92,38 @@ class Mapper {
     constexpr auto get_ptable_posarg(const std::array<const profiles::static_profile*, N>& arr)
     {
         if constexpr  (N == 0) { 
-            return {};
+            return std::span<const profiles::static_profile* const>{};
         } else {
             return std::span<const profiles::static_profile* const>(arr);
         }
     }
 
+    static constexpr bool any_subcommand(std::span<const profiles::static_profile> profs) noexcept {
+        for(const auto& prof : profs) {
+            if(prof.is_subcommand()) return true;
+        }
+        return false;
+    }
+
     public :
-    const MapType map;
+    const DispatchType dispatcher;
+    const dispatch::ShortTable short_table;
+    const suggest::SuggestIndex<IDCount> suggest_index; // only read by a failed parse
     const std::span<const profiles::static_profile> profiles;
     const std::span<const profiles::static_profile* const> posargs;
+    const bool has_subcommands; // bare tokens are looked up only then
+    const constraint::Masks<IDCount> masks; // one bit per profile, IDCount bounds the profile count
 
     template <std::size_t ProfCount, std::size_t PosargCount>
     constexpr Mapper(
-        const MapType& new_map,
+        const DispatchType& new_dispatcher,
+        const dispatch::ShortTable& new_short_table,
+        const suggest::SuggestIndex<IDCount>& new_suggest_index,
         const ProfileTable<ProfCount, PosargCount>& ptable
-    ) : map(new_map), profiles(ptable.static_profiles), posargs(get_ptable_posarg(ptable.get_posargs()))
+    ) : dispatcher(new_dispatcher), short_table(new_short_table), suggest_index(new_suggest_index),
+        profiles(ptable.static_profiles), posargs(get_ptable_posarg(ptable.get_posargs())),
+        has_subcommands(any_subcommand(ptable.static_profiles)),
+        masks(constraint::make_masks<IDCount>(ptable.static_profiles))
     {
         std::size_t valid_mappings = 0;
         for(const auto& prof : profiles) {
@@ -128,9 +153,15 @@ class Mapper {
     }
 
     const profiles::static_profile* operator[](const std::string_view& name) const noexcept {
-        auto it = map.find(frozen::string(name));
-        if(it == map.end()) return nullptr;
-        return it->second;
+        dispatch::IndexT idx = dispatcher.find(name);
+        if(idx == dispatch::npos) return nullptr;
+        return &profiles[idx];
+    }
+
+    const profiles::static_profile* operator[](const ShortName& short_name) const noexcept {
+        dispatch::IndexT idx = short_table.find(short_name.val);
+        if(idx == dispatch::npos) return nullptr;
+        return &profiles[idx];
     }
 
     std::size_t profile_index(const profiles::static_profile* target) const noexcept {
@@ -140,20 +171,109 @@ class Mapper {
 
 using FindPair = std::pair<const profiles::static_profile*, profiles::modifiable_profile*>;
 
+// value of the profile at index from the environment or a config file, NUL separated tokens
+struct FallbackValue {
+    std::size_t index = 0;
+    std::string_view tokens{};
+};
+
+/*
+a RuntimeMapper with a Journal attached reports every profile
+to it right before marking it called, i.e. before a parse changes
+the profile's state (incremental::Validator keeps its undo entries
+this way). note must not throw
+*/
+struct Journal {
+    void* owner = nullptr;
+    void (*note)(void* owner, std::size_t idx) noexcept = nullptr;
+
+    explicit operator bool() const noexcept { return note != nullptr; }
+};
+
+/*
+a RuntimeMapper with a ResetHook attached calls it at the end of
+every reset(), once the values pointing into the owner's storage
+are rewound (ResponseFiles unmaps its files this way).
+on_reset must not throw
+*/
+struct ResetHook {
+    void* owner = nullptr;
+    void (*on_reset)(void* owner) noexcept = nullptr;
+
+    explicit operator bool() const noexcept { return on_reset != nullptr; }
+};
+
 template <std::size_t IDCount>
 class RuntimeMapper {
     private :
     std::span<profiles::modifiable_profile> mutable_profiles;
+    std::span<const FallbackValue> fallbacks{};
+    constraint::BitSet<IDCount> called{};
+    Journal journal{};
+    ResetHook reset_hook{};
     bool is_verified = false;
+    bool rebind_on_reset = false; // see restore_resource
+    std::pmr::memory_resource* resource = default_resource();
+
+    void bind_resource() noexcept {
+        for(profiles::modifiable_profile& mprof : mutable_profiles) {
+            if(values::TrackingDynamic* dyn = mprof.bval.get_if<values::TrackingDynamic>())
+                dyn->arr->adopt_resource(resource);
+        }
+    }
+
     public :
     const Mapper<IDCount>& mapper; // const reference in case mapper is compile-time evaluated object
 
     RuntimeMapper(
         const Mapper<IDCount>& new_mapper,
-        const std::span<profiles::modifiable_profile> new_mutable_profiles
-    ) : mutable_profiles(new_mutable_profiles), mapper(new_mapper) 
+        const std::span<profiles::modifiable_profile> new_mutable_profiles,
+        std::pmr::memory_resource* new_resource = default_resource()
+    ) : mutable_profiles(new_mutable_profiles), resource(new_resource), mapper(new_mapper) 
     {}
 
+    /*
+    every allocation made on behalf of this mapper (error text,
+    DynamicArr bound without its own resource) goes to res,
+    storage previously taken from it is forgotten
+    */
+    void set_resource(std::pmr::memory_resource* res) noexcept {
+        if(!res) return;
+        resource = res;
+        rebind_on_reset = false;
+        bind_resource();
+    }
+
+    /*
+    switches back to res once a parse ran on another resource,
+    the bound DynamicArr keep the storage (and values) they took
+    from the current one until the next reset, which rebinds them.
+    that storage is disowned (see DynamicArr::disown_storage), the
+    parse resource may be destroyed before the reset
+    */
+    void restore_resource(std::pmr::memory_resource* res) noexcept {
+        if(!res or (res == resource)) return;
+        for(profiles::modifiable_profile& mprof : mutable_profiles) {
+            if(values::TrackingDynamic* dyn = mprof.bval.get_if<values::TrackingDynamic>())
+                dyn->arr->disown_storage();
+        }
+        resource = res;
+        rebind_on_reset = true;
+    }
+
+    std::pmr::memory_resource* get_resource() const noexcept { return resource; }
+
+    // applied to uncalled profiles after every parse, see parser::Fallbacks::attach
+    void set_fallbacks(std::span<const FallbackValue> values) noexcept { fallbacks = values; }
+    std::span<const FallbackValue> get_fallbacks() const noexcept { return fallbacks; }
+
+    // Journal{} detaches it
+    void set_journal(Journal new_journal) noexcept { journal = new_journal; }
+
+    // ResetHook{} detaches it
+    void set_reset_hook(ResetHook hook) noexcept { reset_hook = hook; }
+    const ResetHook& get_reset_hook() const noexcept { return reset_hook; }
+
     FindPair operator[](std::size_t idx) {
         if(not is_verified) throw except::ParseError("RuntimeMapper is not initialized");
         const profiles::static_profile* prof = mapper[idx];
@@ -175,6 +295,32 @@ class RuntimeMapper {
         return {prof, &mutable_profiles[mapper.profile_index(prof)]};
     }
 
+    FindPair operator[](const ShortName& short_name) {
+        if(not is_verified) throw except::ParseError("RuntimeMapper is not initialized");
+        const profiles::static_profile* prof = mapper[short_name];
+        if(!prof) return {nullptr, nullptr};
+        return {prof, &mutable_profiles[mapper.profile_index(prof)]};
+    }
+
+    // profiles called since the last reset(), see constraint.hpp
+    void mark_called(std::size_t idx) noexcept {
+        if(journal) journal.note(journal.owner, idx);
+        called.set(idx);
+    }
+    void unmark_called(std::size_t idx) noexcept { called.unset(idx); }
+    const constraint::BitSet<IDCount>& called_set() const noexcept { return called; }
+
+    // rewinds the modifiable_profiles called since the last reset for another parse, verification is kept
+    void reset() {
+        called.for_each([&](std::size_t i) { mutable_profiles[i].reset(); });
+        called.clear();
+        if(rebind_on_reset) {
+            rebind_on_reset = false;
+            bind_resource();
+        }
+        if(reset_hook) reset_hook.on_reset(reset_hook.owner);
+    }
+
     std::size_t existing_profile() const noexcept {
         return mapper.profiles.size();
     }
@@ -183,26 +329,58 @@ class RuntimeMapper {
         return mapper.posargs.size();
     }
 
+    bool verified() const noexcept { return is_verified; }
+
     void verify() {
+        if(const char* err = try_verify())
+            throw except::SetupError(err, resource);
+    }
+
+    /*
+    for bindings checked during constant evaluation (make_rcontext<Ctx>),
+    only the subcommand runtimes are compared to their Context here
+    */
+    void mark_verified() {
+        for(std::size_t i = 0; mapper.has_subcommands and (i < mapper.profiles.size()); i++) {
+            if(mapper.profiles[i].is_subcommand() and (mutable_profiles[i].sub.mapper != mapper.profiles[i].sub_mapper))
+                throw except::SetupError("Subcommand isn't bound to a runtime of its own Context", resource);
+        }
+        bind_resource();
+        is_verified = true;
+    }
+
+    // verify without throwing, returns what's wrong with the bindings, nullptr once verified
+    const char* try_verify() {
         if(mutable_profiles.size() != mapper.profiles.size())
-            throw std::invalid_argument("mutable profile size doesn't match mapper profile size");
+            return "mutable profile size doesn't match mapper profile size";
         std::size_t lim = mapper.profiles.size();
         for(std::size_t i = 0; i < lim; i++) {
             const profiles::static_profile& sprof = *mapper[i];
             profiles::modifiable_profile& mprof = mutable_profiles[i];
 
-            if(mprof.bval.get_code().none()) {
+            if(values::TrackingLazy* lazy = mprof.bval.get_if<values::TrackingLazy>()) {
+                if(lazy->lazy->value_code() != sprof.convert_code)
+                    return "Lazy value type is incompatible with static_profile convert code";
+
+                if(lazy->lazy->capacity() < sprof.narg)
+                    return "Lazy value slots are less than static_profile narg";
+            } else if(values::is_ref_ctgry(mprof.bval.get_code())) {
                 if(mprof.bval.get_code() != sprof.convert_code)    
-                    throw std::invalid_argument("BoundValue variable reference type is incompatible with static_profile convert code");
+                    return "BoundValue variable reference type is incompatible with static_profile convert code";
                 
                 if(sprof.narg > 1)
-                    throw std::invalid_argument("static_profile narg more than 1 is incompatible with variable reference BoundValue");
-            } else {
-                if(mprof.bval.get_value<values::pointing_arr>().viewer.size() < sprof.narg)
-                    throw std::invalid_argument("BoundValue array size is less than static_profile narg");
+                    return "static_profile narg more than 1 is incompatible with variable reference BoundValue";
+            } else if(mprof.bval.get_code() == values::type_code::kRangedArr) {
+                if(mprof.bval.get_value<values::TrackingSpan>().viewer.size() < sprof.narg)
+                    return "BoundValue array size is less than static_profile narg";
             }
+
+            if(sprof.is_subcommand() and (mprof.sub.mapper != sprof.sub_mapper))
+                return "Subcommand isn't bound to a runtime of its own Context";
         }
+        bind_resource();
         is_verified = true;
+        return nullptr;
     }
 };
 }
@@ -0,0 +1,191 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <bit>
+#include <charconv>
+#include <limits>
+#include <string_view>
+
+#include "commons.hpp"
+#include "failure.hpp"
+
+namespace sp {
+namespace parser {
+
+/*
+Token -> number (and boolean) conversions used by convert_and_insert,
+the batch path of fetch_and_next and values::Lazy.
+
+integers go through an 8-digits-at-once SWAR parse,
+anything the fast path can't prove valid falls back
+to std::from_chars so error codes stay the same
+(e.g. '+5' is still "not a number")
+*/
+
+inline ParseErrc from_chars_result_check(const std::from_chars_result& res, std::string_view input) noexcept {
+    if(res.ec == std::errc::invalid_argument) 
+        return ParseErrc::kNotANumber;
+    
+    if(res.ec == std::errc::result_out_of_range)
+        return ParseErrc::kOutOfRange;
+
+    if(res.ptr < (input.data() + input.size()))
+        return ParseErrc::kPartialNumber;
+
+    return ParseErrc::kNone;
+}
+
+namespace swar {
+
+constexpr std::uint64_t kLowNibbles = 0x0F0F0F0F0F0F0F0Full;
+constexpr std::uint64_t kHighNibbles = 0xF0F0F0F0F0F0F0F0ull;
+constexpr std::uint64_t kZeros = 0x3030303030303030ull;
+constexpr std::uint64_t kSixes = 0x0606060606060606ull;
+
+// little-endian load of exactly 8 bytes
+inline std::uint64_t load8(const char* str) noexcept {
+    std::uint64_t v;
+    std::memcpy(&v, str, sizeof(v));
+    if constexpr (std::endian::native == std::endian::big) v = __builtin_bswap64(v);
+    return v;
+}
+
+inline bool all_digits(std::uint64_t v) noexcept {
+    return ((v & kHighNibbles) == kZeros) and (((v + kSixes) & kHighNibbles) == kZeros);
+}
+
+// 8 ascii digits, first char in the lowest byte
+inline std::uint32_t eight_digits(std::uint64_t v) noexcept {
+    v = ((v & kLowNibbles) * 2561) >> 8;
+    v = ((v & 0x00FF00FF00FF00FFull) * 6553601) >> 16;
+    v = ((v & 0x0000FFFF0000FFFFull) * 42949672960001ull) >> 32;
+    return static_cast<std::uint32_t>(v);
+}
+
+// 1..8 digits, left padded with '0' so the value doesn't change
+inline bool upto_eight_digits(const char* str, std::size_t len, std::uint32_t& out) noexcept {
+    char buff[8];
+    std::memset(buff, '0', sizeof(buff));
+    std::memcpy(buff + (8 - len), str, len);
+    std::uint64_t v = load8(buff);
+    if(!all_digits(v)) return false;
+    out = eight_digits(v);
+    return true;
+}
+
+}
+
+/*
+the cheap check a lazily bound token gets at parse time
+(see values::Lazy), the shape of a number without its
+value : the errors it can't see (out of range, "1e+" ...)
+come out of the conversion, when the value is first read
+*/
+constexpr bool is_digit(char c) noexcept { return (c >= '0') and (c <= '9'); }
+
+constexpr ParseErrc check_number_syntax(std::string_view input, bool floating) noexcept {
+    std::size_t i = (!input.empty() and (input[0] == '-')) ? 1 : 0;
+    if(i == input.size()) return ParseErrc::kNotANumber;
+
+    const char first = input[i];
+    if(!floating) {
+        if(!is_digit(first)) return ParseErrc::kNotANumber;
+        for(; i < input.size(); i++) {
+            if(!is_digit(input[i])) return ParseErrc::kPartialNumber;
+        }
+        return ParseErrc::kNone;
+    }
+
+    // inf, infinity, nan, nan(...) are left to from_chars
+    if((first | 0x20) == 'i' or (first | 0x20) == 'n') return ParseErrc::kNone;
+    if(!is_digit(first) and (first != '.')) return ParseErrc::kNotANumber;
+    for(; i < input.size(); i++) {
+        const char c = input[i];
+        if(!is_digit(c) and (c != '.') and (c != 'e') and (c != 'E') and (c != '-') and (c != '+'))
+            return ParseErrc::kPartialNumber;
+    }
+    return ParseErrc::kNone;
+}
+
+inline ParseErrc convert_number(std::string_view input, DobT& out) noexcept {
+    return from_chars_result_check(
+        std::from_chars(input.data(), input.data() + input.size(), out),
+        input
+    );
+}
+
+// the fixed width types go straight through from_chars
+inline ParseErrc convert_number(std::string_view input, I64T& out) noexcept {
+    return from_chars_result_check(
+        std::from_chars(input.data(), input.data() + input.size(), out),
+        input
+    );
+}
+
+inline ParseErrc convert_number(std::string_view input, U64T& out) noexcept {
+    return from_chars_result_check(
+        std::from_chars(input.data(), input.data() + input.size(), out),
+        input
+    );
+}
+
+inline ParseErrc convert_number(std::string_view input, FltT& out) noexcept {
+    return from_chars_result_check(
+        std::from_chars(input.data(), input.data() + input.size(), out),
+        input
+    );
+}
+
+constexpr bool true_word(std::string_view token) noexcept {
+    return (token == "1") or (token == "true") or (token == "yes") or (token == "on");
+}
+
+constexpr bool false_word(std::string_view token) noexcept {
+    return (token == "0") or (token == "false") or (token == "no") or (token == "off");
+}
+
+constexpr ParseErrc convert_bool(std::string_view input, BoolT& out) noexcept {
+    if(true_word(input)) out = true;
+    else if(false_word(input)) out = false;
+    else return ParseErrc::kNotABoolean;
+    return ParseErrc::kNone;
+}
+
+inline ParseErrc convert_number(std::string_view input, IntT& out) noexcept {
+    static_assert(sizeof(IntT) <= 4, "SWAR path assumes IntT fits 10 digits");
+    const bool neg = (!input.empty() and input[0] == '-');
+    const char* digits = input.data() + neg;
+    const std::size_t len = input.size() - neg;
+
+    if((len > 0) and (len <= 10)) {
+        std::uint64_t val = 0;
+        std::uint32_t part = 0;
+        bool ok = true;
+        if(len > 8) {
+            const std::size_t head = len - 8;
+            ok = swar::upto_eight_digits(digits, head, part);
+            val = part;
+            if(ok and (ok = swar::all_digits(swar::load8(digits + head))))
+                val = (val * 100000000ull) + swar::eight_digits(swar::load8(digits + head));
+        } else {
+            ok = swar::upto_eight_digits(digits, len, part);
+            val = part;
+        }
+
+        if(ok) {
+            constexpr std::uint64_t max_pos = static_cast<std::uint64_t>(std::numeric_limits<IntT>::max());
+            if(val > (max_pos + neg)) return ParseErrc::kOutOfRange;
+            out = neg ? static_cast<IntT>(-static_cast<std::int64_t>(val)) : static_cast<IntT>(val);
+            return ParseErrc::kNone;
+        }
+    }
+
+    // slow path decides the exact error
+    return from_chars_result_check(
+        std::from_chars(input.data(), input.data() + input.size(), out),
+        input
+    );
+}
+
+}
+}
@@ -2,17 +2,30 @@
 #include <cstdint>
 #include <string_view>
 #include <cctype>
+#include <type_traits>
 #include <charconv>
+#include <span>
+#include <memory_resource>
+#include <version>
+#ifdef __cpp_lib_expected
+#include <expected>
+#endif
 #include "mapper.hpp"
 #include "profiles.hpp"
 #include "exceptions.hpp"
 #include "values_experiment.hpp"
+#include "failure.hpp"
+#include "numeric.hpp"
+#include "small_buffer.hpp"
+#include "instrument.hpp"
 
 namespace sp {
 
 namespace parser {
 
 using namespace sp;
+using instrument::Phase;
+using instrument::NoInstrument;
 
 bool potential_digit(const char* str) {
     int start = 0;
@@ -20,31 +33,49 @@ bool potential_digit(const char* str) {
     return std::isdigit(str[start]);
 }
 
-void from_chars_result_check(const std::from_chars_result& res, std::string_view input) {
-    if(res.ec == std::errc::invalid_argument) 
-        throw except::ParseError(std::string("Input : ").append(input) + ", Is not a number");
-    
-    if(res.ec == std::errc::result_out_of_range) {
-        throw except::ParseError(std::string("Input : ").append(input) + ", Is out of range"); 
+template <typename T, typename FillF>
+bool convert_fixed(
+    const FillF& fill,
+    std::string_view input,
+    const profiles::static_profile& prof,
+    ParseFailure& fail
+) {
+    T buff{};
+    ParseErrc ec = convert_number(input, buff);
+    if(ec != ParseErrc::kNone) {
+        fail.set(ec, input, &prof);
+        return false;
     }
-
-    if(res.ptr < (input.data() + input.size()))
-        throw except::ParseError(std::string("Can't fully convert").append(input) + " To a number");
+    return fill((void*)&buff, prof.convert_code);
 }
 
-template <typename FillF>
-bool convert_and_insert(const FillF& fill, std::string_view input, values::type_code::Tcode code) {
-    if(input.empty())
-        throw except::ParseError("convert-insert operation failed, input token is empty");
+/*
+false with an untouched fail means the bound value
+denied the value (it's full), not an error
+*/
+template <typename FillF, typename Instr = NoInstrument>
+bool convert_and_insert(
+    const FillF& fill,
+    std::string_view input,
+    const profiles::static_profile& prof,
+    ParseFailure& fail,
+    Instr& instr = instrument::null_instrument
+) {
+    if(input.empty()) {
+        fail.set(ParseErrc::kEmptyToken, input, &prof);
+        return false;
+    }
+    instr.on_convert(prof.convert_code);
     
-    switch(code) {
+    switch(prof.convert_code.value()) {
         case values::type_code::kDob.value() :
             {
                 DobT buff = 0;
-                from_chars_result_check(
-                    std::from_chars(input.data(), input.data() + input.size(), buff),
-                    input
-                );
+                ParseErrc ec = convert_number(input, buff);
+                if(ec != ParseErrc::kNone) {
+                    fail.set(ec, input, &prof);
+                    return false;
+                }
                 return fill((void*)&buff, codeDob);
             }
             break;
@@ -52,36 +83,174 @@ bool convert_and_insert(const FillF& fill, std::string_view input, values::type_
         case codeInt.value() :
             {
                 IntT buff = 0;
-                from_chars_result_check(
-                    std::from_chars(input.data(), input.data() + input.size(), buff),
-                    input
-                );
+                ParseErrc ec = convert_number(input, buff);
+                if(ec != ParseErrc::kNone) {
+                    fail.set(ec, input, &prof);
+                    return false;
+                }
                 return fill((void*)&buff, codeInt);
             }
             break;
 
         case codeStr.value() : 
         {
-            if(input[input.size()] != '\0')
-                throw except::ParseError(std::string("Token : ").append(input) + " Is not null-terminated");
+            if(input[input.size()] != '\0') {
+                fail.set(ParseErrc::kNotNullTerminated, input, &prof);
+                return false;
+            }
             
             const char* dat = input.data();
             return fill((void*)&dat, codeStr);
         }
             break;
 
+        case codeI64.value() :
+            return convert_fixed<I64T>(fill, input, prof, fail);
+
+        case codeU64.value() :
+            return convert_fixed<U64T>(fill, input, prof, fail);
+
+        case codeFlt.value() :
+            return convert_fixed<FltT>(fill, input, prof, fail);
+
+        case codeBool.value() :
+        {
+            BoolT buff = false;
+            ParseErrc ec = convert_bool(input, buff);
+            if(ec != ParseErrc::kNone) {
+                fail.set(ec, input, &prof);
+                return false;
+            }
+            return fill((void*)&buff, codeBool);
+        }
+
+        case codeChoice.value() :
+        {
+            const dispatch::IndexT index = prof.choices.find(input);
+            if(index == dispatch::npos) {
+                fail.set(ParseErrc::kInvalidChoice, input, &prof).known_names = prof.choices.hints;
+                return false;
+            }
+            IntT buff = static_cast<IntT>(index);
+            return fill((void*)&buff, codeChoice);
+        }
+
         default :
-            throw except::ParseError(std::string("Unknown type code of ") + values::type_code::code_to_str(code));
-        
+            fail.set(ParseErrc::kUnknownTypeCode, input, &prof);
+            return false;
+    }
+}
+
+/*
+batch path of fetch_and_next for kInt/kDob profiles bound to an array,
+converts the run of tokens straight into the tracking array
+(TrackingSpan or TrackingDynamic), no fill lambda / fill_method /
+variant check per value. a TrackingLazy only records the tokens
+
+stops at the array capacity (narg if restricted), an empty token,
+or a stop token. returns the first token that wasn't consumed
+*/
+template <typename ValT, typename ArrayT, typename ArgGetF, typename Instr>
+std::string_view convert_run(
+    ArrayT& arr,
+    const profiles::static_profile& prof,
+    const ArgGetF& get,
+    std::size_t limit,
+    std::size_t& consumed,
+    ParseFailure& fail,
+    bool (*check_token)(const std::string_view&),
+    Instr& instr
+) {
+    std::string_view curr_token = get();
+    while(consumed < limit) {
+        if(curr_token.empty() or check_token(curr_token)) break;
+        instr.on_convert(prof.convert_code);
+        ValT buff{};
+        ParseErrc ec = convert_number(curr_token, buff);
+        if(ec != ParseErrc::kNone) {
+            fail.set(ec, curr_token, &prof);
+            return {};
+        }
+        arr.push_back(buff);
+        ++consumed;
+        curr_token = get();
     }
+    return curr_token;
 }
 
+/*
+lazy counterpart of convert_run, records the run of tokens
+in a LazyTokens after check_number_syntax, nothing is converted
+*/
 template <typename ArgGetF>
-std::string_view fetch_and_next(
+std::string_view record_run(
+    values::TrackingLazy& lazy,
+    const profiles::static_profile& prof,
+    const ArgGetF& get,
+    std::size_t limit,
+    std::size_t& consumed,
+    ParseFailure& fail,
+    bool (*check_token)(const std::string_view&)
+) {
+    const bool floating = (prof.convert_code == codeDob);
+    std::string_view curr_token = get();
+    while(consumed < limit) {
+        if(curr_token.empty() or check_token(curr_token)) break;
+        ParseErrc ec = check_number_syntax(curr_token, floating);
+        if(ec != ParseErrc::kNone) {
+            fail.set(ec, curr_token, &prof);
+            return {};
+        }
+        lazy.push_back(curr_token);
+        ++consumed;
+        curr_token = get();
+    }
+    return curr_token;
+}
+
+template <typename ArrayT, typename ArgGetF, typename Instr>
+std::string_view batch_fetch(
+    ArrayT& arr,
+    mapper::FindPair& complete_prof,
+    const ArgGetF& get,
+    std::size_t to_parse,
+    ParseFailure& fail,
+    bool (*check_token)(const std::string_view&),
+    Instr& instr
+) {
+    const profiles::static_profile& static_prof = *complete_prof.first;
+    profiles::modifiable_profile& mod_prof = *complete_prof.second;
+    std::size_t needed = ((signed)to_parse > 0) ? to_parse : 0;
+    std::size_t limit = arr.remaining();
+    if(profiles::is_restricted(static_prof.behave) and (needed < limit)) limit = needed;
+
+    std::size_t consumed = 0;
+    std::string_view curr_token;
+    if constexpr (std::is_same_v<ArrayT, values::TrackingLazy>)
+        curr_token = record_run(arr, static_prof, get, limit, consumed, fail, check_token);
+    else
+        curr_token = (static_prof.convert_code == codeInt)
+            ? convert_run<IntT>(arr, static_prof, get, limit, consumed, fail, check_token, instr)
+            : convert_run<DobT>(arr, static_prof, get, limit, consumed, fail, check_token, instr);
+    if(fail) return {};
+
+    if(consumed < needed) {
+        fail.set(ParseErrc::kInsufficientNarg, curr_token, &static_prof).detail = needed - consumed;
+        return {};
+    }
+    mod_prof.is_called = true;
+    mod_prof.fulfilled_args += consumed;
+    return curr_token;
+}
+
+template <typename ArgGetF, typename Instr>
+std::string_view fetch_impl(
     mapper::FindPair& complete_prof,
     const ArgGetF& get,
     const std::string_view& eq_value,
-    bool (*check_token)(const std::string_view&) = [](const std::string_view& _){ return false; }
+    ParseFailure& fail,
+    bool (*check_token)(const std::string_view&),
+    Instr& instr
 )
 {
     const profiles::static_profile& static_prof = *complete_prof.first;
@@ -95,13 +264,43 @@ std::string_view fetch_and_next(
         return get();
     }
 
+    if(values::TrackingLazy* lazy = mod_prof.bval.get_if<values::TrackingLazy>()) {
+        if(eq_value.empty())
+            return batch_fetch(*lazy, complete_prof, get, to_parse, fail, check_token, instr);
+
+        ParseErrc ec = check_number_syntax(eq_value, static_prof.convert_code == codeDob);
+        if(ec != ParseErrc::kNone) {
+            fail.set(ec, eq_value, &static_prof);
+            return {};
+        }
+        if(lazy->push_back(eq_value)) --to_parse;
+        curr_token = get();
+        if((signed)to_parse > 0) {
+            fail.set(ParseErrc::kInsufficientNarg, curr_token, &static_prof).detail = to_parse;
+            return {};
+        }
+        mod_prof.is_called = true;
+        mod_prof.fulfilled_args += static_prof.narg - (to_parse + mod_prof.fulfilled_args);
+        return curr_token;
+    }
+
+    if(eq_value.empty() and (
+        (static_prof.convert_code == codeInt) or (static_prof.convert_code == codeDob)
+    )) {
+        if(values::TrackingSpan* arr = mod_prof.bval.get_if<values::TrackingSpan>())
+            return batch_fetch(*arr, complete_prof, get, to_parse, fail, check_token, instr);
+        if(values::TrackingDynamic* arr = mod_prof.bval.get_if<values::TrackingDynamic>())
+            return batch_fetch(*arr, complete_prof, get, to_parse, fail, check_token, instr);
+    }
+
     if(!eq_value.empty()) {
-        if(convert_and_insert(fill, eq_value, static_prof.convert_code)) --to_parse;
+        if(convert_and_insert(fill, eq_value, static_prof, fail, instr)) --to_parse;
+        if(fail) return {};
         curr_token = get();
         
     } else {
         curr_token = get();
-        bool ins_res;
+        bool ins_res = false;
         bool stop_token_criteria_are_met = false;
 
         long_fetch :
@@ -110,11 +309,12 @@ std::string_view fetch_and_next(
             if(curr_token.empty()) break;
             if((stop_token_criteria_are_met = check_token(curr_token))) break;
             if(
-                !(ins_res = convert_and_insert(fill, curr_token, static_prof.convert_code))
+                !(ins_res = convert_and_insert(fill, curr_token, static_prof, fail, instr))
             ) break;
             curr_token = get();
             --to_parse;
         }
+        if(fail) return {};
 
         if(
             !ins_res 
@@ -129,124 +329,646 @@ std::string_view fetch_and_next(
         }
     }
 
-    if((signed)to_parse > 0)
-        throw except::ParseError(
-            std::string("Insufficient narg for ") + get_name(static_prof)
-            + ", still needs " + std::to_string(to_parse)
-        );
+    if((signed)to_parse > 0) {
+        fail.set(ParseErrc::kInsufficientNarg, curr_token, &static_prof).detail = to_parse;
+        return {};
+    }
     mod_prof.is_called = true;
     mod_prof.fulfilled_args += static_prof.narg - (to_parse + mod_prof.fulfilled_args);
     return curr_token;
 }
 
-template <typename ArgGetF, typename DumpStoreF, std::size_t IDCount>
-void handle_opt(
+template <typename ArgGetF, typename Instr = NoInstrument>
+std::string_view fetch_and_next(
+    mapper::FindPair& complete_prof,
+    const ArgGetF& get,
+    const std::string_view& eq_value,
+    ParseFailure& fail,
+    bool (*check_token)(const std::string_view&) = [](const std::string_view& _){ return false; },
+    Instr& instr = instrument::null_instrument
+) {
+    instr.phase_begin(Phase::kFetch);
+    std::string_view next_token = fetch_impl(complete_prof, get, eq_value, fail, check_token, instr);
+    instr.phase_end(Phase::kFetch);
+    return next_token;
+}
+
+/*
+counts one call of complete_prof (marks it called for the
+constraint check), false with fail set past its call_limit
+*/
+template <std::size_t IDCount>
+bool count_call(
     mapper::RuntimeMapper<IDCount>& rmap,
-    const ArgGetF& get, 
-    const DumpStoreF& store
+    mapper::FindPair& complete_prof,
+    std::string_view token,
+    ParseFailure& fail
 ) {
-    std::string_view curr_token = get();
+    rmap.mark_called(rmap.mapper.profile_index(complete_prof.first));
+    if(++complete_prof.second->call_count > complete_prof.first->call_limit) {
+        fail.set(ParseErrc::kCallLimit, token, complete_prof.first).detail = complete_prof.first->call_limit;
+        return false;
+    }
+    return true;
+}
+
+/*
+dispatches one option token and fetches its values,
+on_fetched(complete_prof) runs once a profile got them,
+returns the next unconsumed token
+
+"-v" goes through the short name table, anything else
+through the dispatcher. a single dash token no profile owns
+is a cluster of short names (-xvf) : flags (narg 0) are set
+one by one, the first member taking values gets the rest of
+the token as its value (-ofile), or the next tokens when
+it's the last member
+*/
+template <typename ArgGetF, typename OnFetchedF, std::size_t IDCount, typename Instr = NoInstrument>
+std::string_view dispatch_option(
+    mapper::RuntimeMapper<IDCount>& rmap,
+    std::string_view token,
+    const ArgGetF& get,
+    const OnFetchedF& on_fetched,
+    ParseFailure& fail,
+    Instr& instr = instrument::null_instrument
+) {
+    auto stop_token = [](const std::string_view& tk){ return (tk[0] == '-'); };
+    std::string_view name = token;
     std::string_view eq_value{};
-    std::size_t eq_idx = 0;
+    std::size_t eq_idx = token.find('=');
+    if(eq_idx != std::string_view::npos) {
+        eq_value = token.substr(eq_idx + 1);
+        name = token.substr(0, eq_idx);
+    }
+
+    const bool single_dash = (name.size() >= 2) and (name[1] != '-');
+    mapper::FindPair complete_prof = (single_dash and (name.size() == 2))
+        ? rmap[mapper::ShortName(name[1])]
+        : rmap[name];
+    instr.on_lookup(complete_prof.first != nullptr);
+
+    if(complete_prof.first) {
+        if(!count_call(rmap, complete_prof, name, fail)) return {};
+        std::string_view next_token = fetch_and_next(complete_prof, get, eq_value, fail, stop_token, instr);
+        if(fail) return {};
+        on_fetched(complete_prof);
+        return next_token;
+    }
+
+    if(!single_dash or (name.size() == 2)) {
+        fail.set(ParseErrc::kUnknownFlag, name).known_names = rmap.mapper.suggest_index.view();
+        return {};
+    }
 
+    auto no_token = [](){ return std::string_view{}; };
+    for(std::size_t i = 1; i < token.size(); i++) {
+        complete_prof = rmap[mapper::ShortName(token[i])];
+        instr.on_lookup(complete_prof.first != nullptr);
+        if(!complete_prof.first) {
+            fail.set(ParseErrc::kUnknownFlag, token).detail = i;
+            fail.known_names = rmap.mapper.suggest_index.view();
+            return {};
+        }
+        if(!count_call(rmap, complete_prof, token, fail)) return {};
+
+        const bool last = ((i + 1) == token.size());
+        if(last or complete_prof.first->narg) {
+            std::string_view attached = last ? std::string_view{} : token.substr(i + 1);
+            if(!attached.empty() and (attached[0] == '=')) attached.remove_prefix(1); // -xo=file as -o=file
+            std::string_view next_token = fetch_and_next(complete_prof, get, attached, fail, stop_token, instr);
+            if(fail) return {};
+            on_fetched(complete_prof);
+            return next_token;
+        }
+
+        fetch_and_next(complete_prof, no_token, std::string_view{}, fail, stop_token, instr);
+        if(fail) return {};
+        on_fetched(complete_prof);
+    }
+    return {};
+}
+
+/*
+the option pass from curr_token (the last token got) on,
+stored_any tells whether a positional token was stored before it.
+on_fetched(complete_prof) runs once an option got its values,
+on_boundary(stored_any) right before each token starting an
+item (an option and its values, a positional token) is handled
+
+a bare token before any positional one may name a subcommand,
+the pass then stops there and returns it (marked called),
+the tokens after it are left to the subcommand's Context.
+returns {nullptr, nullptr} otherwise
+*/
+template <typename ArgGetF, typename DumpStoreF, typename OnFetchedF, typename OnBoundaryF, std::size_t IDCount, typename Instr>
+mapper::FindPair option_pass(
+    mapper::RuntimeMapper<IDCount>& rmap,
+    std::string_view curr_token,
+    bool stored_any,
+    const ArgGetF& get,
+    const DumpStoreF& store,
+    const OnFetchedF& on_fetched,
+    const OnBoundaryF& on_boundary,
+    ParseFailure& fail,
+    Instr& instr
+) {
     while(!curr_token.empty()) {
+        on_boundary(stored_any);
         if((curr_token[0] != '-') or potential_digit(curr_token.data())) {
+            if(rmap.mapper.has_subcommands and !stored_any) {
+                mapper::FindPair sub = rmap[curr_token];
+                instr.on_lookup(sub.first != nullptr);
+                if(sub.first and sub.first->is_subcommand()) {
+                    if(!count_call(rmap, sub, curr_token, fail)) return {};
+                    sub.second->is_called = true;
+                    return sub;
+                }
+            }
+            stored_any = true;
             store(curr_token);
             curr_token = get();
             continue;
         }
 
-        if((eq_idx = curr_token.find('=')) != std::string_view::npos) {
-            eq_value = curr_token.substr((eq_idx + 1), (curr_token.size() - (eq_idx + 1)));
-            curr_token = curr_token.substr(0, eq_idx);
-        }
-
-        mapper::FindPair complete_prof = rmap[curr_token];
-        if(!complete_prof.first or !complete_prof.second)
-            throw except::ParseError(std::string("Unknown flag was passed : ").append(curr_token));
-        
-        curr_token = fetch_and_next(
-            complete_prof, get, eq_value,
-            [](const std::string_view& token){ return (token[0] == '-'); }
-        );
-        if(profiles::is_immediate(complete_prof.first->behave))
-            complete_prof.second->callback(*complete_prof.first, *complete_prof.second);
-        if(!eq_value.empty())
-            eq_value = std::string_view{};
+        curr_token = dispatch_option(rmap, curr_token, get, on_fetched, fail, instr);
+        if(fail) return {};
     }
+    return {};
+}
+
+// the option pass over every token of get, immediate callbacks run as their option is fetched
+template <typename ArgGetF, typename DumpStoreF, std::size_t IDCount, typename Instr = NoInstrument>
+mapper::FindPair handle_opt(
+    mapper::RuntimeMapper<IDCount>& rmap,
+    const ArgGetF& get, 
+    const DumpStoreF& store,
+    ParseFailure& fail,
+    Instr& instr = instrument::null_instrument
+) {
+    return option_pass(
+        rmap, get(), false, get, store,
+        [&](mapper::FindPair& complete_prof) {
+            if(profiles::is_immediate(complete_prof.first->behave)) {
+                instr.callback_begin();
+                complete_prof.second->callback(*complete_prof.first, *complete_prof.second);
+                instr.callback_end();
+            }
+        },
+        [](bool) {},
+        fail, instr
+    );
 }
 
-template <typename DumpGetF, std::size_t IDCount>
-void handle_posarg(const DumpGetF& dump_get, mapper::RuntimeMapper<IDCount>& rmap) {
+/*
+every posarg takes the tokens the previous one left,
+in positional order. posargs only demand their narg
+once they receive a token, having no positional token
+at all is left to the required check
+*/
+template <typename DumpGetF, std::size_t IDCount, typename Instr = NoInstrument>
+void handle_posarg(
+    const DumpGetF& dump_get,
+    mapper::RuntimeMapper<IDCount>& rmap,
+    ParseFailure& fail,
+    Instr& instr = instrument::null_instrument
+) {
     std::size_t curr_posarg_order = 0;
-    std::string_view curr_token{};
+    std::string_view curr_token = dump_get();
+    std::string_view pending{};
     mapper::FindPair complete_prof;
 
-    while(curr_posarg_order < rmap.existing_posarg()) {
-        complete_prof = rmap[mapper::PosargIndex(curr_posarg_order)];
-        curr_token = fetch_and_next(complete_prof, dump_get, std::string_view{});
-        if(curr_token.empty()) break;
+    auto get = [&]() {
+        if(pending.empty()) return dump_get();
+        std::string_view token = pending;
+        pending = std::string_view{};
+        return token;
+    };
+
+    while(!curr_token.empty() and (curr_posarg_order < rmap.existing_posarg())) {
+        complete_prof = rmap[mapper::PosargIndex(curr_posarg_order++)];
+        if(!count_call(rmap, complete_prof, curr_token, fail)) return;
+        pending = curr_token;
+        curr_token = fetch_and_next(complete_prof, get, std::string_view{}, fail, [](const std::string_view&){ return false; }, instr);
+        if(fail) return;
     }
 
     if(!curr_token.empty())
-        throw except::ParseError(std::string("Unexpected dump inputs of ").append(curr_token));
+        fail.set(ParseErrc::kUnexpectedPosarg, curr_token);
 }
 
-template<std::size_t N>
-struct DumpSize {};
+/*
+profiles the command line left uncalled take their fallback
+value (see fallback.hpp) as if it followed them on the command line,
+the value of a flag (narg 0) is a single boolean word : a true word
+sets it, a false word leaves it uncalled, anything else fails
+with kFallbackNotABoolean. every token of the value must be taken
+*/
+template <std::size_t IDCount, typename Instr = NoInstrument>
+void apply_fallbacks(
+    mapper::RuntimeMapper<IDCount>& rmap,
+    ParseFailure& fail,
+    Instr& instr = instrument::null_instrument
+) {
+    for(const mapper::FallbackValue& fallback : rmap.get_fallbacks()) {
+        mapper::FindPair complete_prof = rmap[fallback.index];
+        if(complete_prof.second->is_called) continue;
 
-template <std::size_t IDCount, std::size_t dump_size>
-void parse(
+        std::size_t pos = 0;
+        auto get = [&]() -> std::string_view {
+            while((pos < fallback.tokens.size()) and (fallback.tokens[pos] == '\0')) ++pos;
+            if(pos >= fallback.tokens.size()) return {};
+            std::string_view token(fallback.tokens.data() + pos);
+            pos += token.size() + 1;
+            return token;
+        };
+
+        // a false word leaves the flag uncalled, for the required / exclusive check too
+        if(!complete_prof.first->narg) {
+            const std::string_view word = get();
+            BoolT value = false;
+            if(convert_bool(word, value) != ParseErrc::kNone) {
+                fail.set(ParseErrc::kFallbackNotABoolean, word, complete_prof.first);
+                return;
+            }
+            const std::string_view rest = get();
+            if(!rest.empty()) {
+                fail.set(ParseErrc::kFallbackSurplus, rest, complete_prof.first);
+                return;
+            }
+            if(value) {
+                rmap.mark_called(fallback.index);
+                complete_prof.second->is_called = true;
+            }
+            continue;
+        }
+
+        rmap.mark_called(fallback.index);
+        std::string_view rest = fetch_and_next(complete_prof, get, std::string_view{}, fail, [](const std::string_view&){ return false; }, instr);
+        if(fail) return;
+        if(!rest.empty()) {
+            fail.set(ParseErrc::kFallbackSurplus, rest, complete_prof.first);
+            return;
+        }
+    }
+}
+
+/*
+end of parse validation over the constraint masks (see constraint.hpp),
+the first required profile left uncalled, then mutually exclusive
+profiles called together (kExcluded, token is the other profile's name)
+*/
+template <std::size_t IDCount>
+void check_constraints(
+    const mapper::Mapper<IDCount>& smapper,
+    const constraint::BitSet<IDCount>& called,
+    ParseFailure& fail
+) {
+    const constraint::Masks<IDCount>& masks = smapper.masks;
+
+    const std::size_t missing = masks.required.first_not_in(called);
+    if(missing != constraint::BitSet<IDCount>::npos) {
+        fail.set(ParseErrc::kRequiredMissing, {}, smapper[missing]);
+        return;
+    }
+
+    const constraint::BitSet<IDCount> exclusive = masks.exclusive & called;
+    if(exclusive.count() < 2) return;
+    exclusive.for_each([&](std::size_t i) {
+        if(fail) return;
+        const profiles::static_profile& prof = *smapper[i];
+        exclusive.for_each([&](std::size_t k) {
+            if(fail or (k >= i)) return;
+            const profiles::static_profile& prev = *smapper[k];
+            if(prev.exclude_point == prof.exclude_point)
+                fail.set(ParseErrc::kExcluded, profiles::get_name(prev), &prof);
+        });
+    });
+}
+
+template <std::size_t IDCount>
+void check_constraints(mapper::RuntimeMapper<IDCount>& rmap, ParseFailure& fail) {
+    check_constraints(rmap.mapper, rmap.called_set(), fail);
+}
+
+// index of the argv entry that token views into, npos if none
+inline std::size_t token_index_of(const char** argv, int argc, std::string_view token) noexcept {
+    if(!token.data()) return ParseFailure::npos;
+    for(int i = 0; i < argc; i++) {
+        std::string_view arg(argv[i]);
+        if((token.data() >= arg.data()) and (token.data() <= (arg.data() + arg.size())))
+            return i;
+    }
+    return ParseFailure::npos;
+}
+
+// positional tokens recorded without allocating, more spill to the mapper's resource
+constexpr std::size_t kInlinePositional = 16;
+
+/*
+run_phases runs the option pass, the positional pass,
+the required check and the callbacks over one token source,
+pos_store(token) records a positional token, pos_get() replays
+them in order (empty = end)
+
+source_fail is the token source's own failure (e.g. an unreadable
+response file), when set it takes over whatever the early end
+of tokens caused
+
+an unverified rmap is verified first, bindings not matching its
+Context give kMapperSetup (token is the try_verify text)
+
+fallback values fill the profiles left uncalled before the
+required check. once the callbacks ran, a selected subcommand
+parses the rest of arg_get with its own RuntimeMapper
+(see parser::subcommand)
+*/
+template <typename ArgGetF, typename PosStoreF, typename PosGetF, std::size_t IDCount, typename Instr>
+ParseFailure run_phases(
     mapper::RuntimeMapper<IDCount>& rmap,
-    const char** argv,
-    int argc,
-    DumpSize<dump_size>
-) {
-    std::array<std::string_view, dump_size> dump{};
-    std::size_t dump_i = 0;
-    std::size_t arg_i = 0;
-    std::size_t dump_get_i = 0;
-    auto arg_get = [&](){
-        if(arg_i == argc) return std::string_view{};
-        return std::string_view(argv[arg_i++]);
-    };
+    const ArgGetF& arg_get,
+    const PosStoreF& pos_store,
+    const PosGetF& pos_get,
+    const ParseFailure* source_fail,
+    Instr& instr
+) {
+    ParseFailure fail{};
+    if(!rmap.verified()) {
+        if(const char* err = rmap.try_verify()) {
+            fail.set(ParseErrc::kMapperSetup, err);
+            return fail;
+        }
+    }
 
-    auto dump_store = [&](const std::string_view& token) -> void {
-        if(dump_i == dump_size)
-            throw except::ParseError("Dump inputs exceed dump size");
-        
-        dump[dump_i++] = token;
+    auto counted_get = [&]() {
+        std::string_view token = arg_get();
+        if(!token.empty()) instr.on_token();
+        return token;
     };
 
-    auto dump_get = [&]() {
-        if(dump_get_i == dump_i) return std::string_view{};
-        
-        return dump[dump_get_i++];
-    };
+    instr.phase_begin(Phase::kOptions);
+    mapper::FindPair selected = handle_opt(rmap, counted_get, pos_store, fail, instr);
+    instr.phase_end(Phase::kOptions);
+    if(source_fail and *source_fail) return *source_fail;
+    if(!fail) {
+        instr.phase_begin(Phase::kPosargs);
+        handle_posarg(pos_get, rmap, fail, instr);
+        instr.phase_end(Phase::kPosargs);
+    }
+    if(!fail and !rmap.get_fallbacks().empty()) {
+        instr.phase_begin(Phase::kFallbacks);
+        apply_fallbacks(rmap, fail, instr);
+        instr.phase_end(Phase::kFallbacks);
+    }
+    if(fail) return fail;
 
-    handle_opt(rmap, arg_get, dump_store);
-    handle_posarg(dump_get, rmap);
+    instr.phase_begin(Phase::kRequired);
+    check_constraints(rmap, fail);
+    instr.phase_end(Phase::kRequired);
+    if(fail) return fail;
 
-    for(std::size_t i{0}; i < rmap.existing_profile(); i++) {
+    instr.phase_begin(Phase::kCallbacks);
+    rmap.called_set().for_each([&](std::size_t i) {
         mapper::FindPair complete_prof = rmap[i];
-        if(profiles::is_required(complete_prof.first->behave) and not (complete_prof.second->is_called)) {
-            throw except::ParseError(
-                (((std::string("A required ")
-                + (complete_prof.first->is_posarg ? "posarg" : "option")    
-                ) + " of \""
-                ) + profiles::get_name(*complete_prof.first)
-                ) + "\" was not called"
-            );
+        if(complete_prof.second->is_called) {
+            instr.callback_begin();
+            complete_prof.second->callback(*complete_prof.first, *complete_prof.second);
+            instr.callback_end();
         }
+    });
+    instr.phase_end(Phase::kCallbacks);
+
+    if(selected.first) {
+        const profiles::SubcommandSlot& sub = selected.second->sub;
+        sub.run(sub.child, arg_get, instrument::InstrumentRef::of(instr), fail);
+        // token holds the error text of the subcommand's try_verify
+        if(fail.code == ParseErrc::kSubcommandSetup) fail.profile = selected.first;
     }
+    return fail;
+}
 
-    for(std::size_t i{0}; i < rmap.existing_profile(); i++) {
-        mapper::FindPair complete_prof = rmap[i];
-        
-        if(complete_prof.second->is_called) 
-            complete_prof.second->callback(*complete_prof.first, *complete_prof.second);
+/*
+run_parse_from is the non-throwing core for any token source,
+arg_get yields the command line tokens one by one (empty = end),
+positional tokens are kept as views.
+an empty (false) ParseFailure means success
+*/
+template <typename ArgGetF, std::size_t IDCount, typename Instr = NoInstrument>
+ParseFailure run_parse_from(
+    mapper::RuntimeMapper<IDCount>& rmap,
+    const ArgGetF& arg_get,
+    const ParseFailure* source_fail = nullptr,
+    Instr& instr = instrument::null_instrument
+) {
+    utils::SmallBuffer<std::string_view, kInlinePositional> positional(rmap.get_resource());
+    std::size_t pos_i = 0;
+
+    return run_phases(
+        rmap, arg_get,
+        [&](const std::string_view& token) { positional.push_back(token); },
+        [&]() {
+            if(pos_i == positional.size()) return std::string_view{};
+            return positional[pos_i++];
+        },
+        source_fail, instr
+    );
+}
+
+template <std::size_t IDCount>
+void run_subcommand(
+    void* child,
+    const profiles::SubcommandSlot::TokenGetF& get,
+    instrument::InstrumentRef instr,
+    ParseFailure& fail
+) {
+    mapper::RuntimeMapper<IDCount>& rmap = *static_cast<mapper::RuntimeMapper<IDCount>*>(child);
+    if(!rmap.verified()) {
+        if(const char* err = rmap.try_verify()) {
+            fail.set(ParseErrc::kSubcommandSetup, err);
+            return;
+        }
+    }
+    fail = run_parse_from(rmap, get, nullptr, instr);
+}
+
+/*
+binds a subcommand to the RuntimeMapper of its Context,
+
+    ModProf().bind_subcommand(parser::subcommand(list_rctx.mapper))
+
+child is only verified when its subcommand gets selected,
+so a RuntimeContext made by make_sub_rcontext costs nothing
+until then. child must outlive the parent mapper
+*/
+template <std::size_t IDCount>
+profiles::SubcommandSlot subcommand(mapper::RuntimeMapper<IDCount>& child) noexcept {
+    profiles::SubcommandSlot slot{};
+    slot.child = &child;
+    slot.mapper = &child.mapper;
+    slot.run = &run_subcommand<IDCount>;
+    slot.reset = [](void* rmap) { static_cast<mapper::RuntimeMapper<IDCount>*>(rmap)->reset(); };
+    return slot;
+}
+
+/*
+run_parse is the non-throwing core shared by parse and try_parse,
+positional tokens are recorded as argv indices and read back
+from argv, no token is copied and there's no bound on their count.
+
+parse failures come back as the ParseFailure, running out of
+rmap's resource doesn't : past kInlinePositional positional tokens
+the index spills to it and a DynamicArr grows in it, so with the
+null resource (STATIC_PARSER_NO_HEAP, see default_resource) and no
+caller resource that throws std::bad_alloc out of run_parse
+*/
+template <std::size_t IDCount, instrument::Instrument Instr = NoInstrument>
+ParseFailure run_parse(
+    mapper::RuntimeMapper<IDCount>& rmap,
+    const char** argv,
+    int argc,
+    Instr& instr = instrument::null_instrument
+) {
+    utils::SmallBuffer<std::uint32_t, kInlinePositional> positional(rmap.get_resource());
+    std::size_t pos_i = 0;
+    int arg_i = 0;
+
+    ParseFailure fail = run_phases(
+        rmap,
+        [&]() {
+            if(arg_i == argc) return std::string_view{};
+            return std::string_view(argv[arg_i++]);
+        },
+        // positional tokens are stored as soon as they're fetched, i.e. argv[arg_i - 1]
+        [&](const std::string_view&) { positional.push_back(static_cast<std::uint32_t>(arg_i - 1)); },
+        [&]() {
+            if(pos_i == positional.size()) return std::string_view{};
+            return std::string_view(argv[positional[pos_i++]]);
+        },
+        nullptr, instr
+    );
+    if(fail) fail.token_index = token_index_of(argv, argc, fail.token);
+    return fail;
+}
+
+inline void throw_failure(
+    const ParseFailure& fail,
+    [[maybe_unused]] std::pmr::memory_resource* resource = default_resource()
+) {
+    #ifdef STATIC_PARSER_NO_HEAP
+    throw except::ParseError(fail.describe());
+    #else
+    throw except::ParseError(fail.message(resource));
+    #endif
+}
+
+template <std::size_t IDCount>
+void parse(
+    mapper::RuntimeMapper<IDCount>& rmap,
+    const char** argv,
+    int argc
+) {
+    ParseFailure fail = run_parse(rmap, argv, argc);
+    if(fail) throw_failure(fail, rmap.get_resource());
+}
+
+template <std::size_t IDCount, instrument::Instrument Instr>
+void parse(
+    mapper::RuntimeMapper<IDCount>& rmap,
+    const char** argv,
+    int argc,
+    Instr& instr
+) {
+    ParseFailure fail = run_parse(rmap, argv, argc, instr);
+    if(fail) throw_failure(fail, rmap.get_resource());
+}
+
+/*
+resource receives every allocation of this parse (error text,
+spilled positional index, DynamicArr bound without its own
+resource), e.g. one monotonic buffer per command line.
+rmap gets its previous resource back on exit, the DynamicArr
+values stay in resource until the next reset (see restore_resource),
+nothing is given back to it afterwards, so it may be destroyed
+before that reset
+*/
+template <std::size_t IDCount>
+void parse(
+    mapper::RuntimeMapper<IDCount>& rmap,
+    const char** argv,
+    int argc,
+    std::pmr::memory_resource* resource
+) {
+    // callbacks may throw as well
+    struct Restore {
+        mapper::RuntimeMapper<IDCount>& rmap;
+        std::pmr::memory_resource* previous;
+        ~Restore() { rmap.restore_resource(previous); }
+    } restore{ rmap, rmap.get_resource() };
+
+    rmap.set_resource(resource);
+    ParseFailure fail = run_parse(rmap, argv, argc);
+    if(fail) throw_failure(fail, resource);
+}
+
+#ifdef __cpp_lib_expected
+/*
+parse failures are the unexpected value, std::bad_alloc from
+rmap's resource still propagates (see run_parse)
+*/
+template <std::size_t IDCount>
+std::expected<void, ParseFailure> try_parse(
+    mapper::RuntimeMapper<IDCount>& rmap,
+    const char** argv,
+    int argc
+) {
+    ParseFailure fail = run_parse(rmap, argv, argc);
+    if(fail) return std::unexpected(fail);
+    return {};
+}
+#endif
+
+// positional tokens are no longer bounded, kept so older call sites still compile
+template<std::size_t N>
+struct DumpSize {};
+
+template <std::size_t IDCount, std::size_t dump_size>
+[[deprecated("positional tokens are unbounded now, drop the DumpSize argument")]]
+void parse(mapper::RuntimeMapper<IDCount>& rmap, const char** argv, int argc, DumpSize<dump_size>) {
+    parse(rmap, argv, argc);
+}
+
+struct ArgvRef {
+    const char** argv = nullptr;
+    int argc = 0;
+};
+
+/*
+parse_many reuses one verified RuntimeMapper for every argv,
+only per-parse state is rewound between them (see RuntimeMapper::reset)
+
+on_parsed(index) is invoked after each successful parse,
+bound values are overwritten by the next one
+*/
+template <std::size_t IDCount, typename OnParsedF>
+void parse_many(
+    mapper::RuntimeMapper<IDCount>& rmap,
+    std::span<const ArgvRef> argvs,
+    const OnParsedF& on_parsed
+) {
+    for(std::size_t i = 0; i < argvs.size(); i++) {
+        rmap.reset();
+        parse(rmap, argvs[i].argv, argvs[i].argc);
+        on_parsed(i);
     }
 }
 
+template <std::size_t IDCount>
+void parse_many(
+    mapper::RuntimeMapper<IDCount>& rmap,
+    std::span<const ArgvRef> argvs
+) {
+    parse_many(rmap, argvs, [](std::size_t){});
+}
+
 }
 }
\ No newline at end of file
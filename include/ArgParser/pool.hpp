@@ -0,0 +1,171 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <functional>
+#include <type_traits>
+
+namespace sp {
+namespace pool {
+
+/*
+Concurrency model
+
+- a Context (static constexpr, constant initialized) is immutable,
+  any number of threads may read it at once, RuntimeMappers only
+  hold a const reference to its Mapper
+- everything a parse writes (modifiable profiles, bound values,
+  DynamicArr storage, the mapper's resource) belongs to one
+  RuntimeContext, which must be used by one thread at a time
+- ContextPool owns Slots pre-built, pre-verified entries
+  (a RuntimeContext, or a struct holding one with its bound storage),
+  a thread leases one, parses, and the lease hands it back
+- leasing is one exchange on the slot's own flag (acquire),
+  returning is one store (release), so the previous holder's writes
+  happen-before the next holder's reads, no lock is taken
+- every flag and every entry sits on its own cache lines, a parse
+  only writes its own entry, threads only share the flags they probe
+- the memory_resource of an entry is used by its holder only,
+  a per-slot arena needs no synchronization (the default
+  new_delete resource is thread safe anyway)
+
+    static constexpr Context<...> ctx(...);
+    struct Job {
+        int count = 0;
+        RuntimeContext<...> rctx;
+        Job() : rctx(make_rcontext(ctx, Request(ModProf().bind(count), "-c"))) {}
+        void reset() { rctx.reset(); }
+    };
+    pool::ContextPool<Job, 16> jobs;
+
+    auto lease = jobs.acquire();
+    parse(lease->rctx.mapper, argv, argc);
+*/
+
+constexpr std::size_t kCacheLine = 64;
+
+template <typename Entry, std::size_t Slots>
+class ContextPool {
+    static_assert(Slots > 0, "ContextPool needs at least one slot");
+
+    private :
+    struct alignas(kCacheLine) Flag {
+        std::atomic<bool> busy{false};
+    };
+
+    struct alignas(kCacheLine) Cell {
+        alignas(Entry) unsigned char storage[sizeof(Entry)];
+        Entry& get() noexcept { return *std::launder(reinterpret_cast<Entry*>(storage)); }
+    };
+
+    Flag flags[Slots];
+    Cell cells[Slots];
+    std::size_t constructed = 0;
+
+    // spreads threads over the slots, so they don't all probe slot 0 first
+    static std::size_t start_hint() noexcept {
+        thread_local const std::size_t hint = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        return hint;
+    }
+
+    void destroy() noexcept {
+        while(constructed) cells[--constructed].get().~Entry();
+    }
+
+    void give_back(std::size_t idx) noexcept {
+        Entry& entry = cells[idx].get();
+        if constexpr (requires(Entry& e) { e.reset(); })
+            entry.reset();
+        flags[idx].busy.store(false, std::memory_order_release);
+    }
+
+    public :
+    class Lease {
+        private :
+        ContextPool* owner = nullptr;
+        std::size_t idx = 0;
+
+        friend class ContextPool;
+        Lease(ContextPool* new_owner, std::size_t new_idx) noexcept : owner(new_owner), idx(new_idx) {}
+
+        public :
+        Lease() noexcept = default;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        Lease(Lease&& oth) noexcept : owner(std::exchange(oth.owner, nullptr)), idx(oth.idx) {}
+
+        Lease& operator=(Lease&& oth) noexcept {
+            if(this != &oth) {
+                release();
+                owner = std::exchange(oth.owner, nullptr);
+                idx = oth.idx;
+            }
+            return *this;
+        }
+
+        ~Lease() { release(); }
+
+        // rewinds the entry (reset() when it has one) and returns it to the pool
+        void release() noexcept {
+            if(owner) std::exchange(owner, nullptr)->give_back(idx);
+        }
+
+        explicit operator bool() const noexcept { return owner != nullptr; }
+        Entry& operator*() const noexcept { return owner->cells[idx].get(); }
+        Entry* operator->() const noexcept { return &owner->cells[idx].get(); }
+        std::size_t slot() const noexcept { return idx; }
+    };
+
+    // every entry is constructed as Entry(args...), verification errors throw from here
+    template <typename... Args>
+    explicit ContextPool(const Args&... args) {
+        try {
+            for(; constructed < Slots; constructed++)
+                ::new (static_cast<void*>(cells[constructed].storage)) Entry(args...);
+        } catch(...) {
+            destroy();
+            throw;
+        }
+    }
+
+    ContextPool(const ContextPool&) = delete;
+    ContextPool& operator=(const ContextPool&) = delete;
+
+    // every lease must be released before
+    ~ContextPool() { destroy(); }
+
+    // empty Lease when every slot is taken
+    Lease try_acquire() noexcept {
+        const std::size_t hint = start_hint();
+        for(std::size_t k = 0; k < Slots; k++) {
+            const std::size_t i = (hint + k) % Slots;
+            if(flags[i].busy.load(std::memory_order_relaxed)) continue;
+            if(!flags[i].busy.exchange(true, std::memory_order_acquire))
+                return Lease(this, i);
+        }
+        return Lease{};
+    }
+
+    // spins (yielding) until a slot is free
+    Lease acquire() noexcept {
+        while(true) {
+            if(Lease lease = try_acquire()) return lease;
+            std::this_thread::yield();
+        }
+    }
+
+    static constexpr std::size_t capacity() noexcept { return Slots; }
+
+    // a snapshot, other threads may change it right away
+    std::size_t in_use() const noexcept {
+        std::size_t count = 0;
+        for(const Flag& flag : flags) count += flag.busy.load(std::memory_order_relaxed);
+        return count;
+    }
+};
+
+}
+}
@@ -3,12 +3,15 @@
 #include "values_experiment.hpp"
 #include "utils.hpp"
 #include "commons.hpp"
+#include "inline_function.hpp"
+#include "instrument.hpp"
+#include "choice.hpp"
 #include <cstdint>
+#include <string_view>
 #include <type_traits>
 
-#include <functional>
-
 namespace sp {
+namespace parser { struct ParseFailure; }
 namespace profiles{
 
 using namespace sp;
@@ -34,12 +37,26 @@ struct ConstructingProfile {
     FlagType behave = 0;
     TypeCodeT convert_code = 0;
     bool posarg = false;
+    const void* sub_mapper = nullptr;
+    NameType env_key = nullptr;
+    NameType config_key = nullptr;
+    NameType description = nullptr;
+    choice::ChoiceView choice_set{};
 
     constexpr void verify() const {
         if(!lname and !sname)
             throw except::comtime_except("Empty name is forbidden");
 
-        if(posarg) {
+        if(sub_mapper) {
+            if(sname)
+                throw except::comtime_except("Subcommand shouldn't have a short name");
+            if(not utils::valid_posarg_name(lname))
+                throw except::comtime_except("Invalid subcommand name format");
+            if(narg)
+                throw except::comtime_except("Subcommand shouldn't take narg, its own Context parses the rest");
+            if(env_key or config_key)
+                throw except::comtime_except("Subcommand shouldn't have fallback keys");
+        } else if(posarg) {
             if(sname) 
                 throw except::comtime_except("Posarg shuldn't not have a short name");
             if(!lname)
@@ -66,9 +83,17 @@ struct ConstructingProfile {
         if(values::is_arr_ctgry(convert_code))
             throw except::comtime_except("Typecode ARRAY doesn't specify any type to convert");
 
+        if((convert_code == values::type_code::kChoice) != static_cast<bool>(choice_set))
+            throw except::comtime_except("Choice convert code and choices() go together");
+
         if(!call_limit)
             throw except::comtime_except("Call limit of 0 are forbidden");
 
+        if(env_key and not utils::valid_posarg_name(env_key))
+            throw except::comtime_except("Invalid environment variable name format");
+        if(config_key and not utils::valid_posarg_name(config_key))
+            throw except::comtime_except("Invalid config key format");
+
     }
 
     friend static_profile;
@@ -116,6 +141,32 @@ struct ConstructingProfile {
         return *this;
     }
 
+    constexpr ConstructingProfile& sub_context(const void* mapper) {
+        sub_mapper = mapper;
+        return *this;
+    }
+
+    constexpr ConstructingProfile& env_fallback(NameType key) {
+        env_key = key;
+        return *this;
+    }
+
+    constexpr ConstructingProfile& config_fallback(NameType key) {
+        config_key = key;
+        return *this;
+    }
+
+    constexpr ConstructingProfile& description_of(NameType text) {
+        description = text;
+        return *this;
+    }
+
+    constexpr ConstructingProfile& choice_of(const choice::ChoiceView& set) {
+        choice_set = set;
+        convert_code = values::type_code::kChoice;
+        return *this;
+    }
+
     constexpr const ConstructingProfile& profile() const noexcept { return *this; }
     constexpr NameType short_name() const noexcept { return sname; }
     constexpr NameType long_name() const noexcept { return lname; }
@@ -175,6 +226,30 @@ struct BasicOption : protected ConstructingProfile {
         return static_cast<Derived&>(*this);
     }
 
+    // fallback value when not given on the command line, see fallback.hpp
+    constexpr Derived& env(NameType key) noexcept {
+        this->env_fallback(key);
+        return static_cast<Derived&>(*this);
+    }
+
+    constexpr Derived& config(NameType key) noexcept {
+        this->config_fallback(key);
+        return static_cast<Derived&>(*this);
+    }
+
+    // one line of the generated help text, see usage.hpp
+    constexpr Derived& describe(NameType text) noexcept {
+        this->description_of(text);
+        return static_cast<Derived&>(*this);
+    }
+
+    // the allowed words (sets codeChoice), see choice.hpp
+    template <std::size_t N>
+    constexpr Derived& choices(const choice::ChoiceSet<N>& set) noexcept {
+        this->choice_of(set.view());
+        return static_cast<Derived&>(*this);
+    }
+
     constexpr const ConstructingProfile& profile() const noexcept { return *this; }
 };
 
@@ -215,6 +290,27 @@ struct BasicPosarg : protected ConstructingProfile {
         return static_cast<Derived&>(*this);
     }
 
+    constexpr Derived& env(NameType key) noexcept {
+        this->env_fallback(key);
+        return static_cast<Derived&>(*this);
+    }
+
+    constexpr Derived& config(NameType key) noexcept {
+        this->config_fallback(key);
+        return static_cast<Derived&>(*this);
+    }
+
+    constexpr Derived& describe(NameType text) noexcept {
+        this->description_of(text);
+        return static_cast<Derived&>(*this);
+    }
+
+    template <std::size_t N>
+    constexpr Derived& choices(const choice::ChoiceSet<N>& set) noexcept {
+        this->choice_of(set.view());
+        return static_cast<Derived&>(*this);
+    }
+
     constexpr const ConstructingProfile& profile() const noexcept { return *this; }
 };
 
@@ -250,6 +346,30 @@ struct Posarg : public BasicPosarg<Posarg> {
     static constexpr int id_count = 1;
 };
 
+/*
+a bare word ("list" of "jobs list -l") handing the rest of
+the command line to the Context given to context(),
+which must be a static constexpr object
+
+    static constexpr Context<...> list_ctx(...);
+    static constexpr Context<...> jobs_ctx(
+        snOpt()("--verbose"),
+        subCmd()("list").context(list_ctx)
+    );
+*/
+struct Subcommand : public BasicOption<Subcommand> {
+    public :
+    static constexpr int id_count = 1;
+
+    constexpr Subcommand& operator[](NameType) = delete;
+
+    template <typename SubContext>
+    constexpr Subcommand& context(const SubContext& ctx) noexcept {
+        this->sub_context(&ctx.mapper);
+        return *this;
+    }
+};
+
 
 template <typename T>
 concept DenotedProfile = 
@@ -269,6 +389,11 @@ struct static_profile {
     const NumT exclude_point = -1;
     const TypeCodeT convert_code = 0;
     const bool is_posarg = false;
+    const void* const sub_mapper = nullptr; // Mapper of the subcommand's Context, nullptr if not a subcommand
+    const NameType env_key = nullptr;
+    const NameType config_key = nullptr;
+    const NameType description = nullptr;
+    const choice::ChoiceView choices{}; // allowed words of a kChoice profile
 
     static_profile() = delete;
     constexpr static_profile(const ConstructingProfile& construct_prof)
@@ -281,31 +406,64 @@ struct static_profile {
         behave(construct_prof.behave),
         exclude_point(construct_prof.exclude_point),
         convert_code(construct_prof.convert_code),
-        is_posarg(construct_prof.posarg)
+        is_posarg(construct_prof.posarg),
+        sub_mapper(construct_prof.sub_mapper),
+        env_key(construct_prof.env_key),
+        config_key(construct_prof.config_key),
+        description(construct_prof.description),
+        choices(construct_prof.choice_set)
     {
         construct_prof.verify();
     }
 
     constexpr static_profile(const static_profile& oth) = default;
+
+    constexpr bool is_subcommand() const noexcept { return sub_mapper != nullptr; }
 };
+
+/*
+runtime side of a subcommand, a type erased reference to the
+RuntimeMapper of its Context, made by parser::subcommand(child).
+run parses the rest of the tokens with it (verifying it first
+if it isn't yet), reset rewinds it
+*/
+struct SubcommandSlot {
+    using TokenGetF = utils::InlineFunction<std::string_view()>;
+    using RunF = void (*)(void* child, const TokenGetF& get, instrument::InstrumentRef instr, parser::ParseFailure& fail);
+    using ResetF = void (*)(void* child);
+
+    void* child = nullptr;
+    const void* mapper = nullptr;
+    RunF run = nullptr;
+    ResetF reset = nullptr;
+
+    explicit operator bool() const noexcept { return child != nullptr; }
+};
+
 struct modifiable_profile {
     bool is_called = false;
     WholeNumT call_count = 0;
     WholeNumT fulfilled_args = 0;
-    #ifdef STATIC_PARSER_NO_HEAP
-    using FunctionType = void(*)(static_profile, modifiable_profile&);
-    #else
-    using FunctionType = std::function<void(static_profile, modifiable_profile&)>;
-    #endif
-    FunctionType callback = [](static_profile, modifiable_profile&){};
+    using FunctionType = utils::InlineFunction<void(const static_profile&, modifiable_profile&)>;
+    FunctionType callback{};
     values::BoundValue bval;
+    SubcommandSlot sub{};
     WholeNumT call_frequent() const noexcept { return call_count; }
     template <typename T>
     modifiable_profile& bind(T& var) { bval.bind(var); return *this; }
+    modifiable_profile& bind_subcommand(const SubcommandSlot& slot) { sub = slot; return *this; }
     modifiable_profile& set_callback(FunctionType&& func) { callback = func; return *this; }
+    // rewinds per-parse state only, binding and callback are kept (a selected subcommand is rewound too)
+    void reset() {
+        if(is_called and sub) sub.reset(sub.child);
+        is_called = false;
+        call_count = 0;
+        fulfilled_args = 0;
+        bval.track_reset();
+    }
 };
 
-const char* get_name(const static_profile& prof) {
+constexpr const char* get_name(const static_profile& prof) {
     return (prof.lname ? prof.lname : prof.sname);
 }
 
@@ -0,0 +1,315 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <array>
+#include <string_view>
+#include <memory_resource>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "parser.hpp"
+
+namespace sp {
+namespace parser {
+
+/*
+Response files (@path)
+
+every token of the form @path (argv or inside another
+response file) is replaced by the tokens of that file.
+
+the file is mmap'd MAP_PRIVATE and tokenized in place :
+quotes / backslashes are removed by compacting the token
+inside the mapping and the byte after each token is turned
+into its NUL terminator, so every token, codeStr included,
+is a view into the mapping, nothing is copied into strings
+and the file on disk is never written. the only copy is a
+token that ends exactly at the end of the file (no byte left
+for its NUL), it goes to the resource.
+
+the cost of writing in place : the first write to a page of
+the mapping makes the kernel copy it (copy-on-write), since
+nearly every page holds a token end, expanding a file costs
+about its size in private memory plus one page fault per page,
+on top of reading it. that's still a single pass over the file
+and no allocation per token, a read-only mapping would need
+a copy of every codeStr token instead.
+
+syntax : tokens are separated by whitespace, '...' and "..."
+group whitespace, a backslash escapes the next character,
+an empty token ("") is dropped since an empty view ends
+the token stream of the parser.
+
+ResponseFiles owns the mappings, StrT values and views from
+a response file stay valid until they're unmapped : when the
+RuntimeMapper parsing with it resets (the values are rewound
+then, see attach), on release() or destruction. so it must
+outlive the bound values that use them, and the RuntimeMapper
+must outlive it. MaxDepth bounds nesting (an @self loop fails
+instead of recursing), MaxFiles bounds the mappings of one parse.
+*/
+
+template <std::size_t MaxDepth = 8, std::size_t MaxFiles = 64>
+class ResponseFiles {
+    private :
+    struct Mapping {
+        void* addr = nullptr;
+        std::size_t size = 0;
+        char* copy = nullptr; // the token ending the file, if it was copied
+        std::size_t copy_size = 0;
+    };
+
+    struct Frame {
+        char* curr = nullptr;
+        char* end = nullptr;
+        std::size_t map = 0;
+    };
+
+    std::array<Mapping, MaxFiles> maps{};
+    std::size_t map_count = 0;
+    std::array<Frame, MaxDepth> frames{};
+    std::size_t depth = 0;
+
+    const char** argv = nullptr;
+    int argc = 0;
+    int arg_i = 0;
+
+    std::pmr::memory_resource* resource;
+    ParseFailure fail{};
+
+    // the RuntimeMapper whose resets unmap the files, see attach
+    void* attached = nullptr;
+    void (*detach_from)(void* rmap, const void* owner) noexcept = nullptr;
+
+    static void on_reset(void* owner) noexcept {
+        static_cast<ResponseFiles*>(owner)->release();
+    }
+
+    static constexpr bool is_space(char c) noexcept {
+        return (c == ' ') or (c == '\t') or (c == '\n') or (c == '\r') or (c == '\v') or (c == '\f');
+    }
+
+    // empty view when the frame is exhausted
+    std::string_view next_in_frame(Frame& frame) {
+        char* read = frame.curr;
+        char* const end = frame.end;
+
+        while(read != end) {
+            while((read != end) and is_space(*read)) ++read;
+            if(read == end) break;
+
+            char* const start = read;
+            char* write = read;
+            char quote = '\0';
+            while(read != end) {
+                char c = *read;
+                if(quote) {
+                    if(c == quote) { quote = '\0'; ++read; continue; }
+                } else {
+                    if(is_space(c)) break;
+                    if((c == '\'') or (c == '"')) { quote = c; ++read; continue; }
+                }
+                if((c == '\\') and ((read + 1) != end)) c = *++read;
+                *write++ = c;
+                ++read;
+            }
+
+            const std::size_t len = write - start;
+            if(read != end) ++read; // the separator, or a byte freed by compaction
+            frame.curr = read;
+            if(!len) continue;
+
+            if(write != end) {
+                *write = '\0';
+                return std::string_view(start, len);
+            }
+
+            Mapping& mapping = maps[frame.map];
+            char* copy = static_cast<char*>(resource->allocate(len + 1, alignof(char)));
+            std::memcpy(copy, start, len);
+            copy[len] = '\0';
+            mapping.copy = copy;
+            mapping.copy_size = len + 1;
+            return std::string_view(copy, len);
+        }
+
+        frame.curr = end;
+        return {};
+    }
+
+    // false (with fail set) when the file can't be expanded
+    bool open(std::string_view token) {
+        if(depth == MaxDepth) {
+            fail.set(ParseErrc::kResponseFileDepth, token);
+            return false;
+        }
+        if(map_count == MaxFiles) {
+            fail.set(ParseErrc::kResponseFileLimit, token);
+            return false;
+        }
+
+        // argv and in-place tokens are NUL-terminated, skip '@'
+        const char* path = token.data() + 1;
+        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if(fd < 0) {
+            fail.set(ParseErrc::kResponseFileOpen, token).detail = errno;
+            return false;
+        }
+
+        struct stat st{};
+        if(::fstat(fd, &st) != 0) {
+            fail.set(ParseErrc::kResponseFileOpen, token).detail = errno;
+            ::close(fd);
+            return false;
+        }
+
+        const std::size_t size = static_cast<std::size_t>(st.st_size);
+        void* addr = nullptr;
+        if(size) {
+            addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if(addr == MAP_FAILED) {
+                fail.set(ParseErrc::kResponseFileOpen, token).detail = errno;
+                ::close(fd);
+                return false;
+            }
+            ::madvise(addr, size, MADV_SEQUENTIAL);
+        }
+        ::close(fd);
+
+        maps[map_count] = Mapping{ addr, size };
+        char* base = static_cast<char*>(addr);
+        frames[depth++] = Frame{ base, base + size, map_count++ };
+        return true;
+    }
+
+    public :
+    explicit ResponseFiles(std::pmr::memory_resource* res = default_resource())
+        : resource(res) {}
+
+    ResponseFiles(const ResponseFiles&) = delete;
+    ResponseFiles& operator=(const ResponseFiles&) = delete;
+
+    ~ResponseFiles() {
+        detach();
+        release();
+    }
+
+    /*
+    unmaps every file when rmap resets (parse / try_parse
+    attach it), a mapper attached before is detached
+    */
+    template <std::size_t IDCount>
+    void attach(mapper::RuntimeMapper<IDCount>& rmap) noexcept {
+        if(attached == &rmap) return;
+        detach();
+        rmap.set_reset_hook(mapper::ResetHook{ this, &ResponseFiles::on_reset });
+        attached = &rmap;
+        detach_from = [](void* target, const void* owner) noexcept {
+            mapper::RuntimeMapper<IDCount>& hooked = *static_cast<mapper::RuntimeMapper<IDCount>*>(target);
+            if(hooked.get_reset_hook().owner == owner) hooked.set_reset_hook(mapper::ResetHook{});
+        };
+    }
+
+    void detach() noexcept {
+        if(attached) detach_from(attached, this);
+        attached = nullptr;
+        detach_from = nullptr;
+    }
+
+    // unmaps every file (and frees the copied tokens), views from them (StrT values included) dangle afterwards
+    void release() noexcept {
+        for(std::size_t i = 0; i < map_count; i++) {
+            if(maps[i].addr) ::munmap(maps[i].addr, maps[i].size);
+            if(maps[i].copy) resource->deallocate(maps[i].copy, maps[i].copy_size, alignof(char));
+            maps[i] = Mapping{};
+        }
+        map_count = 0;
+        depth = 0;
+    }
+
+    // starts a new token stream, mappings of a previous one are kept until release()
+    void begin(const char** new_argv, int new_argc) noexcept {
+        argv = new_argv;
+        argc = new_argc;
+        arg_i = 0;
+        depth = 0;
+        fail = ParseFailure{};
+    }
+
+    // next expanded token, empty at the end or on failure
+    std::string_view next() {
+        if(fail) return {};
+        while(true) {
+            std::string_view token;
+            if(depth) {
+                token = next_in_frame(frames[depth - 1]);
+                if(token.empty()) {
+                    --depth;
+                    continue;
+                }
+            } else {
+                if(arg_i == argc) return {};
+                token = argv[arg_i++];
+            }
+
+            if((token.size() > 1) and (token[0] == '@')) {
+                if(!open(token)) return {};
+                continue;
+            }
+            return token;
+        }
+    }
+
+    const ParseFailure& failure() const noexcept { return fail; }
+    std::size_t mapped_files() const noexcept { return map_count; }
+    std::pmr::memory_resource* get_resource() const noexcept { return resource; }
+};
+
+template <std::size_t IDCount, std::size_t MaxDepth, std::size_t MaxFiles>
+ParseFailure run_parse(
+    mapper::RuntimeMapper<IDCount>& rmap,
+    const char** argv,
+    int argc,
+    ResponseFiles<MaxDepth, MaxFiles>& rsp
+) {
+    rsp.attach(rmap);
+    rsp.begin(argv, argc);
+    auto arg_get = [&](){ return rsp.next(); };
+
+    ParseFailure fail = run_parse_from(rmap, arg_get, &rsp.failure());
+    if(fail) fail.token_index = token_index_of(argv, argc, fail.token);
+    return fail;
+}
+
+// parse with @path expansion, rsp keeps the files mapped for the parsed values
+template <std::size_t IDCount, std::size_t MaxDepth, std::size_t MaxFiles>
+void parse(
+    mapper::RuntimeMapper<IDCount>& rmap,
+    const char** argv,
+    int argc,
+    ResponseFiles<MaxDepth, MaxFiles>& rsp
+) {
+    ParseFailure fail = run_parse(rmap, argv, argc, rsp);
+    if(fail) throw_failure(fail, rmap.get_resource());
+}
+
+#ifdef __cpp_lib_expected
+template <std::size_t IDCount, std::size_t MaxDepth, std::size_t MaxFiles>
+std::expected<void, ParseFailure> try_parse(
+    mapper::RuntimeMapper<IDCount>& rmap,
+    const char** argv,
+    int argc,
+    ResponseFiles<MaxDepth, MaxFiles>& rsp
+) {
+    ParseFailure fail = run_parse(rmap, argv, argc, rsp);
+    if(fail) return std::unexpected(fail);
+    return {};
+}
+#endif
+
+}
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <memory_resource>
+
+#include "commons.hpp"
+
+namespace sp {
+namespace utils {
+
+/*
+SmallBuffer is an append-only array of trivially copyable
+values, the first Inline of them live inside the object,
+past that it spills to a memory_resource (doubling).
+
+used for per-parse scratch like the positional index,
+the common case never allocates and a huge one costs a
+few allocations from the parse's resource (an arena
+release is enough to drop it)
+*/
+
+template <typename T, std::size_t Inline>
+class SmallBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "SmallBuffer only holds trivially copyable values");
+    static_assert(Inline > 0, "SmallBuffer needs an inline capacity");
+
+    private :
+    T local[Inline];
+    T* items = local;
+    std::size_t count = 0;
+    std::size_t cap = Inline;
+    std::pmr::memory_resource* resource;
+
+    void grow() {
+        const std::size_t new_cap = cap * 2;
+        T* new_items = static_cast<T*>(resource->allocate(new_cap * sizeof(T), alignof(T)));
+        std::memcpy(new_items, items, count * sizeof(T));
+        release();
+        items = new_items;
+        cap = new_cap;
+    }
+
+    void release() noexcept {
+        if(items != local) resource->deallocate(items, cap * sizeof(T), alignof(T));
+        items = local;
+        cap = Inline;
+    }
+
+    public :
+    explicit SmallBuffer(std::pmr::memory_resource* res = default_resource()) noexcept
+        : resource(res) {}
+
+    SmallBuffer(const SmallBuffer&) = delete;
+    SmallBuffer& operator=(const SmallBuffer&) = delete;
+
+    ~SmallBuffer() { release(); }
+
+    void push_back(const T& val) {
+        if(count == cap) grow();
+        items[count++] = val;
+    }
+
+    // keeps the spilled storage for reuse
+    void clear() noexcept { count = 0; }
+    void truncate(std::size_t n) noexcept { if(n < count) count = n; }
+
+    std::size_t size() const noexcept { return count; }
+    std::size_t capacity() const noexcept { return cap; }
+    bool spilled() const noexcept { return items != local; }
+    const T& operator[](std::size_t i) const noexcept { return items[i]; }
+    const T* begin() const noexcept { return items; }
+    const T* end() const noexcept { return items + count; }
+};
+
+}
+}
@@ -1,57 +1,87 @@
 #pragma once
 
-#include <iostream>
+#include <memory_resource>
 
 #include "commons.hpp"
 #include "exceptions.hpp"
 #include "utils.hpp"
-#include "values.hpp"
+#include "values_experiment.hpp"
+#include "dispatch.hpp"
+#include "suggest.hpp"
 #include "profiles.hpp"
 #include "mapper.hpp"
 #include "parser.hpp"
+#include "lazy.hpp"
 
 namespace sp {
 
 // main interface to user
 using sp::parser::parse;
+using sp::parser::parse_many;
+#ifdef __cpp_lib_expected
+using sp::parser::try_parse;
+#endif
+using sp::parser::ParseFailure;
+using sp::parser::ParseErrc;
+using sp::parser::ArgvRef;
+using sp::parser::subcommand;
 using namespace sp;
 using snOpt = profiles::snOption;
 using dnOpt = profiles::dnOption;
 using posArg = profiles::Posarg;
-using type_code = values::TypeCode;
+using subCmd = profiles::Subcommand;
+namespace type_code = values::type_code;
 using ModProf = profiles::modifiable_profile;
-using PointingArr = values::pointing_arr;
+using PointingArr = values::TrackingSpan;
+using DynamicArr = values::DynamicArr;
+template <typename T, std::size_t N = 1>
+using Lazy = values::Lazy<T, N>;
 
-template <std::size_t IDCount, std::size_t... Is>
-constexpr auto
-make_map_pairs(
-    std::array<std::pair<profiles::NameType, const profiles::static_profile*>, IDCount>& extracted,
-    std::index_sequence<Is...>
-) {
-    return std::array<std::pair<frozen::string, const profiles::static_profile*>, IDCount>
-    {{
-        {frozen::string(extracted[Is].first), extracted[Is].second}...
-    }};
+// SetupError under STATIC_PARSER_NO_HEAP, std::invalid_argument (its message is copied on the heap) otherwise
+[[noreturn]] inline void throw_setup(const char* msg) {
+    #ifdef STATIC_PARSER_NO_HEAP
+    throw except::SetupError(msg);
+    #else
+    throw std::invalid_argument(msg);
+    #endif
 }
 
 template <std::size_t IDCount>
-constexpr
-frozen::unordered_map<frozen::string, const profiles::static_profile*, IDCount>
-make_map(const std::span<const profiles::static_profile>& profiles) { 
-    std::array<std::pair<profiles::NameType, const profiles::static_profile*>, IDCount> extracted{};
+constexpr std::array<dispatch::NameEntry, IDCount>
+extract_names(const std::span<const profiles::static_profile>& profiles) {
+    std::array<dispatch::NameEntry, IDCount> extracted{};
     std::size_t curr_idx = 0;
-    for(const auto& prof : profiles) {
-        if(prof.lname) extracted[curr_idx++] = {prof.lname, &prof};
-        if(prof.sname) extracted[curr_idx++] = {prof.sname, &prof};
+    for(std::size_t i = 0; i < profiles.size(); i++) {
+        if(profiles[i].lname) extracted[curr_idx++] = {profiles[i].lname, i};
+        if(profiles[i].sname) extracted[curr_idx++] = {profiles[i].sname, i};
     }
 
     if(curr_idx != IDCount) 
         throw except::comtime_except("nullptr in name !");
 
-    return 
-    frozen::make_unordered_map<frozen::string, const profiles::static_profile*>(
-        make_map_pairs(extracted, std::make_index_sequence<IDCount>{})
-    );
+    return extracted;
+}
+
+template <std::size_t IDCount>
+constexpr dispatch::NameDispatcher<IDCount>
+make_dispatcher(const std::span<const profiles::static_profile>& profiles) { 
+    return dispatch::NameDispatcher<IDCount>(extract_names<IDCount>(profiles));
+}
+
+template <std::size_t IDCount>
+constexpr suggest::SuggestIndex<IDCount>
+make_suggest_index(const std::span<const profiles::static_profile>& profiles) {
+    return suggest::SuggestIndex<IDCount>(extract_names<IDCount>(profiles));
+}
+
+// one slot per character, from sname[1] of every short name
+constexpr dispatch::ShortTable make_short_table(const std::span<const profiles::static_profile>& profiles) {
+    dispatch::ShortTable table{};
+    for(std::size_t i = 0; i < profiles.size(); i++) {
+        if(profiles[i].sname and (profiles[i].sname[0] == '-') and profiles[i].sname[1] and !profiles[i].sname[2])
+            table.insert(profiles[i].sname[1], i);
+    }
+    return table;
 }
 
 template <std::size_t IDCount, std::size_t ProfCount, std::size_t PosargCount>
@@ -64,16 +94,21 @@ struct Context {
     template <profiles::DenotedProfile... Prof>
     constexpr Context(const Prof&... prof)
     : ptable(prof...),
-      mapper(make_map<IDCount>(ptable.static_profiles), ptable)
+      mapper(
+        make_dispatcher<IDCount>(ptable.static_profiles),
+        make_short_table(ptable.static_profiles),
+        make_suggest_index<IDCount>(ptable.static_profiles),
+        ptable
+      )
     {}
 
     profiles::modifiable_profile& match(std::span<profiles::modifiable_profile> mprof, const profiles::NameType& name) const {
         const profiles::static_profile* prof = mapper[name];
         if(!prof) 
-            throw std::invalid_argument("Unknown name");
+            throw_setup("Unknown name");
         std::size_t index = ptable.profile_index(prof);
         if(index >= mprof.size())
-            throw std::invalid_argument("Can't get profile : index out of range from mprof");
+            throw_setup("Can't get profile : index out of range from mprof");
         return mprof[index];
     }
 
@@ -116,6 +151,12 @@ struct Request {
 template <typename T>
 concept IsRequest = std::is_same_v<std::decay_t<T>, Request>;
 
+// RuntimeContext constructor tag, verification is left to the first parse selecting it
+struct LazyVerify {};
+
+// RuntimeContext constructor tag, the Requests were placed and checked at compile time (make_rcontext<Ctx>)
+struct PreVerified {};
+
 template <std::size_t ProfCount, std::size_t IDCount>
 struct RuntimeContext {
     std::array<sp::ModProf, ProfCount> mprofs{};
@@ -123,7 +164,7 @@ struct RuntimeContext {
 
     void apply_request(Request& req) {
         if(req.request.placement_index >= ProfCount)
-            throw except::SetupError("Request placement index is out of bounds");
+            throw except::SetupError("Request placement index is out of bounds", mapper.get_resource());
         mprofs[req.request.placement_index] = req.mprof;
         
     }
@@ -131,33 +172,287 @@ struct RuntimeContext {
     template <IsRequest... Req>
     RuntimeContext(
         const mapper::Mapper<IDCount>& smapper,
+        std::pmr::memory_resource* resource,
+        LazyVerify,
         Req&&... req
     )
-    : mapper(smapper, mprofs)
+    : mapper(smapper, mprofs, resource)
     {
-        
         (apply_request(req), ...);
+    }
+
+    template <IsRequest... Req>
+    RuntimeContext(
+        const mapper::Mapper<IDCount>& smapper,
+        std::pmr::memory_resource* resource,
+        PreVerified,
+        Req&&... req
+    )
+    : RuntimeContext(smapper, resource, LazyVerify{}, std::forward<Req>(req)...)
+    {
+        mapper.mark_verified();
+    }
+
+    template <IsRequest... Req>
+    RuntimeContext(
+        const mapper::Mapper<IDCount>& smapper,
+        std::pmr::memory_resource* resource,
+        Req&&... req
+    )
+    : RuntimeContext(smapper, resource, LazyVerify{}, std::forward<Req>(req)...)
+    {
         mapper.verify();
     }
+
+    template <IsRequest... Req>
+    RuntimeContext(
+        const mapper::Mapper<IDCount>& smapper,
+        Req&&... req
+    )
+    : RuntimeContext(smapper, default_resource(), std::forward<Req>(req)...)
+    {}
+
+    // mapper holds a span over mprofs, moving or copying would dangle it
+    RuntimeContext(const RuntimeContext&) = delete;
+    RuntimeContext& operator=(const RuntimeContext&) = delete;
+
+    void reset() { mapper.reset(); }
 };
 
 template <typename IndexGetF>
-void set_request(const IndexGetF& index_get, Request& req) {
+void set_request(
+    const IndexGetF& index_get,
+    Request& req,
+    std::pmr::memory_resource* resource = default_resource()
+) {
     NumT idx = index_get(req.request.name);
-    if(idx < 0)
-        throw except::SetupError((std::string("Unknown name of \"") + req.request.name) + "\", in Request");
+    if(idx < 0) {
+        #ifdef STATIC_PARSER_NO_HEAP
+        throw except::SetupError("Unknown name in Request", resource);
+        #else
+        std::pmr::string msg("Unknown name of \"", resource);
+        msg.append(req.request.name).append("\", in Request");
+        throw except::SetupError(std::move(msg));
+        #endif
+    }
     req.request.placement_index = idx;
 }
 
 template <std::size_t IDCount, std::size_t ProfCount, std::size_t PosargCount, IsRequest... Req>
 auto make_rcontext(
+    std::pmr::memory_resource* resource,
     const Context<IDCount, ProfCount, PosargCount>& ctx,
     Req&&... req
 ) {
-    (set_request(ctx.get_index_func(), req), ...);
+    (set_request(ctx.get_index_func(), req, resource), ...);
     
-    return RuntimeContext<ProfCount, IDCount>(ctx.mapper, std::forward<Req>(req)...);
+    return RuntimeContext<ProfCount, IDCount>(ctx.mapper, resource, std::forward<Req>(req)...);
+}
+
+template <std::size_t IDCount, std::size_t ProfCount, std::size_t PosargCount, IsRequest... Req>
+auto make_rcontext(
+    const Context<IDCount, ProfCount, PosargCount>& ctx,
+    Req&&... req
+) {
+    return make_rcontext(default_resource(), ctx, std::forward<Req>(req)...);
+}
+
+/*
+RuntimeContext of a subcommand's Context, only verified
+when a parse selects its subcommand
+*/
+template <std::size_t IDCount, std::size_t ProfCount, std::size_t PosargCount, IsRequest... Req>
+auto make_sub_rcontext(
+    std::pmr::memory_resource* resource,
+    const Context<IDCount, ProfCount, PosargCount>& ctx,
+    Req&&... req
+) {
+    (set_request(ctx.get_index_func(), req, resource), ...);
+
+    return RuntimeContext<ProfCount, IDCount>(ctx.mapper, resource, LazyVerify{}, std::forward<Req>(req)...);
 }
 
+template <std::size_t IDCount, std::size_t ProfCount, std::size_t PosargCount, IsRequest... Req>
+auto make_sub_rcontext(
+    const Context<IDCount, ProfCount, PosargCount>& ctx,
+    Req&&... req
+) {
+    return make_sub_rcontext(default_resource(), ctx, std::forward<Req>(req)...);
+}
+
+template <std::size_t ProfCount, std::size_t IDCount>
+profiles::SubcommandSlot subcommand(RuntimeContext<ProfCount, IDCount>& child) noexcept {
+    return parser::subcommand(child.mapper);
+}
+
+/*
+Compile-time Requests
+
+    static constexpr Context<...> ctx(...);
+    IntT count = 0;
+    std::array<Blob, 4> ports{};
+    auto rctx = make_rcontext<ctx>(
+        bind_to<"-c">(count),
+        bind_to<"--ports">(ports),
+        on_call<"--help">(print_help)
+    );
+
+the name of a StaticRequest is resolved to its profile and the
+type of its variable checked against the profile (convert code,
+narg, subcommand) while compiling, as verify() would at runtime.
+an unknown name, a mismatch, two requests of one profile or an
+unbound subcommand fail the build. the RuntimeContext is only
+filled, there's no name lookup and no verify() at runtime
+(a subcommand runtime is still compared to its Context).
+
+the Context must be a static constexpr object (taken as a
+const auto& template argument). like constinit, constexpr
+makes it constant initialized, startup does no parser work
+*/
+
+template <typename T>
+struct is_runtime_context : std::false_type {};
+
+template <std::size_t ProfCount, std::size_t IDCount>
+struct is_runtime_context<RuntimeContext<ProfCount, IDCount>> : std::true_type {};
+
+template <typename T>
+struct is_blob_array : std::false_type {};
+
+template <std::size_t N>
+struct is_blob_array<std::array<Blob, N>> : std::true_type {};
+
+template <typename T>
+constexpr TypeCodeT scalar_code() noexcept {
+    if constexpr (std::is_enum_v<T>) return values::type_code::kChoice;
+    else if constexpr (std::is_same_v<T, IntT>) return values::type_code::kInt;
+    else if constexpr (std::is_same_v<T, DobT>) return values::type_code::kDob;
+    else if constexpr (std::is_same_v<T, StrT>) return values::type_code::kStr;
+    else if constexpr (std::is_same_v<T, I64T>) return values::type_code::kI64;
+    else if constexpr (std::is_same_v<T, U64T>) return values::type_code::kU64;
+    else if constexpr (std::is_same_v<T, FltT>) return values::type_code::kFlt;
+    else if constexpr (std::is_same_v<T, BoolT>) return values::type_code::kBool;
+    else static_assert(!sizeof(T), "Unsupported type of a bound variable");
+}
+
+// the checks of verify() for a T bound to prof, a compile error on a mismatch
+template <typename T>
+constexpr void check_binding(const profiles::static_profile& prof) {
+    if constexpr (is_runtime_context<T>::value) {
+        if(!prof.is_subcommand())
+            throw except::comtime_except("Only a subcommand profile takes a RuntimeContext");
+    } else if constexpr (!std::is_void_v<T>) {
+        if(prof.is_subcommand())
+            throw except::comtime_except("A subcommand profile takes the RuntimeContext of its Context");
+
+        if constexpr (is_blob_array<T>::value) {
+            if(std::tuple_size_v<T> < prof.narg)
+                throw except::comtime_except("Bound array size is less than static_profile narg");
+        } else if constexpr (std::is_base_of_v<values::LazyTokens, T>) {
+            if(scalar_code<typename T::value_type>() != prof.convert_code)
+                throw except::comtime_except("Lazy value type is incompatible with static_profile convert code");
+            if(T::slot_count < prof.narg)
+                throw except::comtime_except("Lazy value slots are less than static_profile narg");
+        } else if constexpr (!std::is_same_v<T, DynamicArr>) {
+            if(scalar_code<T>() != prof.convert_code)
+                throw except::comtime_except("Bound variable type is incompatible with static_profile convert code");
+            if(prof.narg > 1)
+                throw except::comtime_except("static_profile narg more than 1 is incompatible with variable reference");
+        }
+    }
+}
+
+template <utils::FixedString Name, typename T>
+struct StaticRequest {
+    using value_type = T;
+    static constexpr utils::FixedString name = Name;
+
+    T* var = nullptr;
+    ModProf::FunctionType callback{};
+
+    StaticRequest& on_call(ModProf::FunctionType func) {
+        callback = std::move(func);
+        return *this;
+    }
+
+    // index of the profile named Name in Ctx, a compile error when it can't take a T
+    template <const auto& Ctx>
+    static consteval std::size_t index() {
+        const dispatch::IndexT idx = Ctx.mapper.dispatcher.find(Name.view());
+        if(idx == dispatch::npos)
+            throw except::comtime_except("Unknown name in StaticRequest");
+        check_binding<T>(Ctx.ptable.static_profiles[idx]);
+        return idx;
+    }
+
+    template <const auto& Ctx>
+    Request placed() const {
+        constexpr std::size_t idx = index<Ctx>();
+        ModProf mprof{};
+        if constexpr (is_runtime_context<T>::value) mprof.bind_subcommand(subcommand(*var));
+        else if constexpr (!std::is_void_v<T>) mprof.bind(*var);
+        if(callback) mprof.set_callback(ModProf::FunctionType(callback));
+        Request req(std::move(mprof), name.data);
+        req.request.placement_index = idx;
+        return req;
+    }
+};
+
+template <utils::FixedString Name, typename T>
+StaticRequest<Name, T> bind_to(T& var) noexcept { return StaticRequest<Name, T>{ &var }; }
+
+template <utils::FixedString Name>
+StaticRequest<Name, void> on_call(ModProf::FunctionType func) {
+    StaticRequest<Name, void> req{};
+    req.on_call(std::move(func));
+    return req;
+}
+
+template <typename T>
+struct is_static_request : std::false_type {};
+
+template <utils::FixedString Name, typename T>
+struct is_static_request<StaticRequest<Name, T>> : std::true_type {};
+
+template <typename T>
+concept IsStaticRequest = is_static_request<std::decay_t<T>>::value;
+
+// no profile requested twice, every subcommand bound
+template <const auto& Ctx, typename... Req>
+consteval bool check_requests() {
+    constexpr std::size_t count = sizeof...(Req);
+    const std::array<std::size_t, count> indexes{ Req::template index<Ctx>()... };
+    const std::array<bool, count> to_runtime{ is_runtime_context<typename Req::value_type>::value... };
+    for(std::size_t i = 0; i < count; i++) {
+        for(std::size_t k = 0; k < i; k++) {
+            if(indexes[i] == indexes[k])
+                throw except::comtime_except("Two StaticRequests of the same profile");
+        }
+    }
+
+    const auto& profs = Ctx.ptable.static_profiles;
+    for(std::size_t p = 0; p < profs.size(); p++) {
+        if(!profs[p].is_subcommand()) continue;
+        bool bound = false;
+        for(std::size_t i = 0; i < count; i++) bound = bound or ((indexes[i] == p) and to_runtime[i]);
+        if(!bound)
+            throw except::comtime_except("Subcommand isn't bound to a RuntimeContext by a StaticRequest");
+    }
+    return true;
+}
+
+template <const auto& Ctx, IsStaticRequest... Req>
+auto make_rcontext(std::pmr::memory_resource* resource, Req&&... req) {
+    using ContextType = std::decay_t<decltype(Ctx)>;
+    static_assert(check_requests<Ctx, std::decay_t<Req>...>());
+    return RuntimeContext<ContextType::prof_count, ContextType::id_count>(
+        Ctx.mapper, resource, PreVerified{}, req.template placed<Ctx>()...
+    );
+}
+
+template <const auto& Ctx, IsStaticRequest... Req>
+auto make_rcontext(Req&&... req) {
+    return make_rcontext<Ctx>(default_resource(), std::forward<Req>(req)...);
+}
 
 }
\ No newline at end of file
@@ -0,0 +1,277 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <string_view>
+
+#include <unistd.h>
+
+#include "parser.hpp"
+
+namespace sp {
+namespace parser {
+
+/*
+Streaming parse
+
+tokens are pulled from a file descriptor (pipe, socket, file)
+through a fixed buffer instead of a whole argv, options are
+dispatched and their callbacks fired as soon as their values
+are fetched, so memory stays constant however long the input is.
+
+    FdTokenSource<> src(STDIN_FILENO);
+    parse_stream(rctx.mapper, src);
+
+differences with parse :
+- every callback fires right away (as if immediate), the option
+  values are then rewound for its next occurrence, its call count
+  is kept so call_limit holds over the whole stream,
+- positional tokens go straight to the posargs (no dump),
+  posargs are filled in order as one record, each one fires
+  its callback when satisfied (restricted narg reached, bound
+  value full, or an option / end of input) and is then rewound,
+  after the last posarg the next record starts, e.g. one
+  restricted posarg with narg 2 behaves like `xargs -n 2`.
+  the input may end in a record missing only optional posargs,
+  a missing required one fails with kInsufficientNarg,
+- StrT values and token views only live until the callback
+  returns, the buffer is compacted right after it. the tokens
+  of one option (or one posarg batch) must fit the buffer,
+  bind posargs to a bounded array to keep batches small.
+*/
+
+template <std::size_t Capacity = 64 * 1024>
+class FdTokenSource {
+    static_assert(Capacity >= 2, "FdTokenSource needs room for a token and its NUL");
+
+    private :
+    char buff[Capacity];
+    std::size_t curr = 0;   // scan position
+    std::size_t filled = 0; // valid bytes, buff[filled] is always writable
+    int fd;
+    bool null_separated;
+    bool eof = false;
+    ParseFailure fail{};
+    std::size_t tokens = 0;
+    std::size_t bytes = 0;
+
+    bool is_delim(char c) const noexcept {
+        if(null_separated) return c == '\0';
+        return (c == ' ') or (c == '\t') or (c == '\n') or (c == '\r') or (c == '\v') or (c == '\f');
+    }
+
+    // false at end of input or failure
+    bool fill() {
+        if(eof or fail) return false;
+        const std::size_t room = (Capacity - 1) - filled;
+        if(!room) {
+            fail.set(ParseErrc::kStreamOverflow).detail = Capacity;
+            return false;
+        }
+
+        ssize_t got = 0;
+        do got = ::read(fd, buff + filled, room);
+        while((got < 0) and (errno == EINTR));
+
+        if(got < 0) {
+            fail.set(ParseErrc::kStreamRead).detail = errno;
+            return false;
+        }
+        if(got == 0) {
+            eof = true;
+            return false;
+        }
+        filled += static_cast<std::size_t>(got);
+        bytes += static_cast<std::size_t>(got);
+        return true;
+    }
+
+    public :
+    /*
+    null_separated splits on '\0' only (find -print0 / xargs -0),
+    otherwise on whitespace, no quoting either way
+    */
+    explicit FdTokenSource(int src_fd, bool null_sep = false) noexcept
+        : fd(src_fd), null_separated(null_sep) {}
+
+    FdTokenSource(const FdTokenSource&) = delete;
+    FdTokenSource& operator=(const FdTokenSource&) = delete;
+
+    // next NUL-terminated token, empty at the end of input or on failure
+    std::string_view next() {
+        while(true) {
+            while((curr < filled) and is_delim(buff[curr])) ++curr;
+            if(curr < filled) break;
+            if(!fill()) return {};
+        }
+
+        const std::size_t start = curr;
+        std::size_t scan = curr;
+        while(true) {
+            while((scan < filled) and !is_delim(buff[scan])) ++scan;
+            if((scan < filled) or !fill()) break;
+        }
+        if(fail) return {};
+
+        // the delimiter, or the spare byte after the last token
+        buff[scan] = '\0';
+        curr = (scan < filled) ? (scan + 1) : scan;
+        ++tokens;
+        return std::string_view(buff + start, scan - start);
+    }
+
+    /*
+    drops every byte before live (the only token still in use,
+    or empty) and returns live moved to the front of the buffer
+    */
+    std::string_view release(std::string_view live) noexcept {
+        const std::size_t from = live.empty() ? curr : static_cast<std::size_t>(live.data() - buff);
+        std::memmove(buff, buff + from, (filled - from) + 1);
+        filled -= from;
+        curr -= from;
+        return live.empty() ? live : std::string_view(buff, live.size());
+    }
+
+    const ParseFailure& failure() const noexcept { return fail; }
+    std::size_t token_count() const noexcept { return tokens; }
+    std::size_t byte_count() const noexcept { return bytes; }
+};
+
+struct StreamStats {
+    std::size_t tokens = 0;
+    std::size_t bytes = 0;
+    std::size_t callbacks = 0; // callbacks fired, options and posarg batches
+    std::size_t records = 0;   // complete rounds over the posargs
+    double seconds = 0;
+
+    double tokens_per_second() const noexcept {
+        return (seconds > 0) ? (static_cast<double>(tokens) / seconds) : 0;
+    }
+};
+
+// rewinds the values of an occurrence, the call count stays for call_limit
+inline void rewind_occurrence(profiles::modifiable_profile& mprof) {
+    const WholeNumT calls = mprof.call_count;
+    mprof.reset();
+    mprof.call_count = calls;
+}
+
+/*
+run_stream is the non-throwing core of parse_stream,
+SourceT provides next(), release(live) and failure()
+(plus token_count() / byte_count() for the stats)
+*/
+template <std::size_t IDCount, typename SourceT>
+ParseFailure run_stream(mapper::RuntimeMapper<IDCount>& rmap, SourceT& src, StreamStats& stats) {
+    using clock = std::chrono::steady_clock;
+    const clock::time_point start = clock::now();
+
+    ParseFailure fail{};
+    if(!rmap.verified()) {
+        if(const char* err = rmap.try_verify()) {
+            fail.set(ParseErrc::kMapperSetup, err);
+            return fail;
+        }
+    }
+
+    std::string_view pending{};
+    auto get = [&]() {
+        if(pending.empty()) return src.next();
+        std::string_view token = pending;
+        pending = std::string_view{};
+        return token;
+    };
+
+    const std::size_t posarg_count = rmap.existing_posarg();
+    std::size_t posarg_order = 0;
+    std::string_view curr_token = get();
+
+    while(!curr_token.empty()) {
+        mapper::FindPair complete_prof;
+
+        if((curr_token[0] != '-') or potential_digit(curr_token.data())) {
+            if(!posarg_count) {
+                fail.set(ParseErrc::kUnexpectedPosarg, curr_token);
+                break;
+            }
+
+            complete_prof = rmap[mapper::PosargIndex(posarg_order)];
+            if(!count_call(rmap, complete_prof, curr_token, fail)) break;
+            pending = curr_token;
+            curr_token = fetch_and_next(
+                complete_prof, get, std::string_view{}, fail,
+                [](const std::string_view& token){ return (token[0] == '-') and !potential_digit(token.data()); }
+            );
+            if(fail) break;
+            if(!complete_prof.second->fulfilled_args) {
+                fail.set(ParseErrc::kUnexpectedPosarg, curr_token);
+                break;
+            }
+
+            complete_prof.second->callback(*complete_prof.first, *complete_prof.second);
+            complete_prof.second->reset(); // one call per record
+            ++stats.callbacks;
+            if(++posarg_order == posarg_count) {
+                posarg_order = 0;
+                ++stats.records;
+            }
+        } else {
+            curr_token = dispatch_option(
+                rmap, curr_token, get,
+                [&](mapper::FindPair& fetched) {
+                    fetched.second->callback(*fetched.first, *fetched.second);
+                    rewind_occurrence(*fetched.second);
+                    ++stats.callbacks;
+                },
+                fail
+            );
+            if(fail) break;
+        }
+
+        curr_token = src.release(curr_token);
+    }
+
+    if(src.failure()) fail = src.failure();
+
+    /*
+    a partial record, only its remaining required posargs fail it :
+    detail is the count of tokens they miss, profile the first of them.
+    without any the record ends there
+    */
+    if(!fail and posarg_order) {
+        const profiles::static_profile* first_missing = nullptr;
+        std::size_t missing = 0;
+        for(std::size_t i = posarg_order; i < posarg_count; i++) {
+            const profiles::static_profile* prof = rmap.mapper[mapper::PosargIndex(i)];
+            if(!profiles::is_required(prof->behave) or !prof->narg) continue;
+            if(!first_missing) first_missing = prof;
+            missing += prof->narg;
+        }
+        if(first_missing) fail.set(ParseErrc::kInsufficientNarg, {}, first_missing).detail = missing;
+        else ++stats.records;
+    }
+
+    // called bits outlive the per occurrence / per record resets
+    if(!fail) check_constraints(rmap, fail);
+
+    stats.tokens = src.token_count();
+    stats.bytes = src.byte_count();
+    stats.seconds = std::chrono::duration<double>(clock::now() - start).count();
+    return fail;
+}
+
+template <std::size_t IDCount, typename SourceT>
+void parse_stream(mapper::RuntimeMapper<IDCount>& rmap, SourceT& src, StreamStats& stats) {
+    ParseFailure fail = run_stream(rmap, src, stats);
+    if(fail) throw_failure(fail, rmap.get_resource());
+}
+
+template <std::size_t IDCount, typename SourceT>
+void parse_stream(mapper::RuntimeMapper<IDCount>& rmap, SourceT& src) {
+    StreamStats stats{};
+    parse_stream(rmap, src, stats);
+}
+
+}
+}
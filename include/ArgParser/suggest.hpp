@@ -0,0 +1,156 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <span>
+#include <algorithm>
+#include <string_view>
+
+#include "commons.hpp"
+#include "dispatch.hpp"
+
+namespace sp {
+namespace suggest {
+
+/*
+"did you mean" suggestions for an unknown flag
+
+SuggestIndex is a flat array of every name of a Context,
+sorted by length, built during constant evaluation next to
+the dispatcher. nothing of it runs on a successful parse,
+a failed one only records a span over it, closest() runs
+when the failure message is written.
+
+closest() only looks at names whose length is within
+kMaxDistance of the token and computes a banded, bounded
+optimal string alignment distance (a swap of two neighbour
+characters counts as one edit) on the stack, no allocation.
+a suggestion needs a distance smaller than the typed name
+without its dashes, so "-q" doesn't suggest every short name
+*/
+
+constexpr std::size_t kMaxDistance = 2;
+constexpr std::size_t kMaxSuggestions = 3;
+
+struct Entry {
+    NameType name = nullptr;
+    std::size_t len = 0;
+    dispatch::IndexT value = dispatch::npos;
+};
+
+struct Match {
+    NameType name = nullptr;
+    std::size_t distance = 0;
+};
+
+struct Suggestions {
+    std::array<Match, kMaxSuggestions> matches{};
+    std::size_t count = 0;
+
+    constexpr bool empty() const noexcept { return count == 0; }
+    constexpr std::size_t size() const noexcept { return count; }
+    constexpr const Match* begin() const noexcept { return matches.data(); }
+    constexpr const Match* end() const noexcept { return matches.data() + count; }
+    constexpr const Match& operator[](std::size_t i) const noexcept { return matches[i]; }
+};
+
+// edit distance of a and b, Limit + 1 when it's above Limit
+template <std::size_t Limit = kMaxDistance>
+constexpr std::size_t bounded_distance(std::string_view a, std::string_view b) noexcept {
+    constexpr std::size_t kOver = Limit + 1;
+    constexpr std::size_t kWidth = 2 * Limit + 1;
+    const std::size_t n = a.size();
+    const std::size_t m = b.size();
+    if(((n > m) ? (n - m) : (m - n)) > Limit) return kOver;
+
+    // a row keeps D[i][j] for j in [i - Limit, i + Limit], at j - i + Limit
+    std::array<std::size_t, kWidth> before{};
+    std::array<std::size_t, kWidth> prev{};
+    std::array<std::size_t, kWidth> curr{};
+    before.fill(kOver);
+    for(std::size_t o = 0; o < kWidth; o++) {
+        const std::size_t j = o - Limit; // wraps when negative
+        prev[o] = ((o >= Limit) and (j <= m)) ? std::min(j, kOver) : kOver;
+    }
+
+    for(std::size_t i = 1; i <= n; i++) {
+        std::size_t row_min = kOver;
+        for(std::size_t o = 0; o < kWidth; o++) {
+            if((i + o) < Limit or (i + o - Limit) > m) {
+                curr[o] = kOver;
+                continue;
+            }
+            const std::size_t j = i + o - Limit;
+            std::size_t val = i;
+            if(j) {
+                val = prev[o] + ((a[i - 1] != b[j - 1]) ? 1 : 0);
+                if((o + 1) < kWidth) val = std::min(val, prev[o + 1] + 1);
+                if(o) val = std::min(val, curr[o - 1] + 1);
+                if((i > 1) and (j > 1) and (a[i - 1] == b[j - 2]) and (a[i - 2] == b[j - 1]))
+                    val = std::min(val, before[o] + 1);
+            }
+            curr[o] = std::min(val, kOver);
+            row_min = std::min(row_min, curr[o]);
+        }
+        if(row_min > Limit) return kOver;
+        before = prev;
+        prev = curr;
+    }
+    return prev[m + Limit - n];
+}
+
+constexpr std::size_t dashless_size(std::string_view name) noexcept {
+    std::size_t dashes = 0;
+    while((dashes < name.size()) and (dashes < 2) and (name[dashes] == '-')) ++dashes;
+    return name.size() - dashes;
+}
+
+// up to kMaxSuggestions names of entries closest to token, nearest first
+constexpr Suggestions closest(std::span<const Entry> entries, std::string_view token) noexcept {
+    Suggestions res{};
+    const std::size_t core = dashless_size(token);
+    if(!core) return res;
+
+    const std::size_t min_len = (token.size() > kMaxDistance) ? (token.size() - kMaxDistance) : 0;
+    const Entry* it = std::lower_bound(
+        entries.data(), entries.data() + entries.size(), min_len,
+        [](const Entry& entry, std::size_t len) { return entry.len < len; }
+    );
+
+    for(; (it != entries.data() + entries.size()) and (it->len <= token.size() + kMaxDistance); it++) {
+        const std::size_t distance = bounded_distance(std::string_view(it->name, it->len), token);
+        if((distance > kMaxDistance) or (distance >= core)) continue;
+
+        std::size_t pos = res.count;
+        while(pos and (res.matches[pos - 1].distance > distance)) {
+            if(pos < kMaxSuggestions) res.matches[pos] = res.matches[pos - 1];
+            --pos;
+        }
+        if(pos == kMaxSuggestions) continue;
+        res.matches[pos] = Match{ it->name, distance };
+        if(res.count < kMaxSuggestions) ++res.count;
+    }
+    return res;
+}
+
+template <std::size_t N>
+class SuggestIndex {
+    private :
+    std::array<Entry, N> entries{};
+
+    public :
+    SuggestIndex() = delete;
+    constexpr SuggestIndex(const std::array<dispatch::NameEntry, N>& names) {
+        for(std::size_t i = 0; i < N; i++)
+            entries[i] = Entry{ names[i].name, std::string_view(names[i].name).size(), names[i].value };
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.len < b.len; });
+    }
+
+    constexpr std::span<const Entry> view() const noexcept { return entries; }
+
+    constexpr Suggestions closest(std::string_view token) const noexcept {
+        return suggest::closest(view(), token);
+    }
+};
+
+}
+}
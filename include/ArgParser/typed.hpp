@@ -0,0 +1,430 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <tuple>
+#include <utility>
+#include <string_view>
+#include <type_traits>
+
+#include "static_parser.hpp"
+
+namespace sp {
+namespace typed {
+
+/*
+Typed schema mode
+
+every profile is tied at compile time to a field of a user struct :
+
+    struct Opts { bool verbose; typed::List<int, 8> ports; const char* file; };
+
+    typed::make_context<Opts>(
+        typed::field<&Opts::verbose>(dnOpt()("--verbose")["-v"]),
+        typed::field<&Opts::ports>(snOpt()("--ports").nargs(1).convert(codeInt)),
+        typed::field<&Opts::file>(posArg()("file").nargs(1).convert(codeStr))
+    );
+
+parse fills the struct directly, the profile index found by the
+dispatcher selects fully typed code, there's no BoundValue,
+no void* and no RuntimeMapper::verify, field/profile compatibility
+is checked when the context is constant evaluated.
+
+short name clusters, call_limit, required and exclusive profiles
+behave as in parser::parse (check_constraints is shared), there are
+no callbacks, env / config fallbacks and subcommands are rejected
+when the context is constant evaluated.
+
+supported field types : bool (a narg 0 flag, or a codeBool value),
+IntT, DobT, StrT, I64T, U64T, FltT, an enum (choices(), gets the
+index of the word), List<any of them but a flag, N>
+*/
+
+template <typename T, std::size_t N>
+struct List {
+    std::array<T, N> items{};
+    std::size_t count = 0;
+    static constexpr std::size_t capacity = N;
+
+    bool push_back(const T& val) noexcept {
+        if(count >= N) return false;
+        items[count++] = val;
+        return true;
+    }
+
+    void clear() noexcept { count = 0; }
+    std::size_t size() const noexcept { return count; }
+    const T* begin() const noexcept { return items.data(); }
+    const T* end() const noexcept { return items.data() + count; }
+    const T& operator[](std::size_t i) const noexcept { return items[i]; }
+};
+
+template <typename T>
+struct member_traits;
+
+template <typename S, typename M>
+struct member_traits<M S::*> {
+    using struct_type = S;
+    using member_type = M;
+};
+
+// convert code of a field value, an enum takes the index of a choices() word
+template <typename T>
+struct value_code {
+    static_assert(
+        std::is_enum_v<T>,
+        "Unsupported typed field value : bool, IntT, DobT, StrT, I64T, U64T, FltT or an enum (choices())"
+    );
+    static constexpr TypeCodeT code = values::type_code::kChoice;
+};
+
+template <> struct value_code<IntT> { static constexpr TypeCodeT code = values::type_code::kInt; };
+template <> struct value_code<DobT> { static constexpr TypeCodeT code = values::type_code::kDob; };
+template <> struct value_code<StrT> { static constexpr TypeCodeT code = values::type_code::kStr; };
+template <> struct value_code<I64T> { static constexpr TypeCodeT code = values::type_code::kI64; };
+template <> struct value_code<U64T> { static constexpr TypeCodeT code = values::type_code::kU64; };
+template <> struct value_code<FltT> { static constexpr TypeCodeT code = values::type_code::kFlt; };
+template <> struct value_code<BoolT> { static constexpr TypeCodeT code = values::type_code::kBool; };
+
+template <typename T>
+struct field_traits {
+    using value_type = T;
+    static constexpr bool is_flag = false;
+    static constexpr bool is_list = false;
+    static constexpr std::size_t capacity = 1;
+    static constexpr TypeCodeT code = value_code<T>::code;
+};
+
+// a flag when its profile has no narg, a codeBool value otherwise
+template <>
+struct field_traits<bool> {
+    using value_type = bool;
+    static constexpr bool is_flag = true;
+    static constexpr bool is_list = false;
+    static constexpr std::size_t capacity = 1;
+    static constexpr TypeCodeT code = values::type_code::kBool;
+};
+
+template <typename T, std::size_t N>
+struct field_traits<List<T, N>> {
+    using value_type = T;
+    static constexpr bool is_flag = false;
+    static constexpr bool is_list = true;
+    static constexpr std::size_t capacity = N;
+    static constexpr TypeCodeT code = value_code<T>::code;
+};
+
+template <auto Member, profiles::DenotedProfile Prof>
+struct Field {
+    using member = member_traits<decltype(Member)>;
+    using traits = field_traits<typename member::member_type>;
+    static constexpr auto pointer = Member;
+    Prof prof;
+};
+
+template <auto Member, profiles::DenotedProfile Prof>
+constexpr Field<Member, Prof> field(const Prof& prof) { return Field<Member, Prof>{ prof }; }
+
+template <typename Struct, typename... Fields>
+struct TypedContext {
+    static constexpr std::size_t id_count = (std::decay_t<decltype(Fields::prof)>::id_count + ...);
+    using ContextType = Context<
+        id_count,
+        sizeof...(Fields),
+        count_posargs<std::decay_t<decltype(Fields::prof)>...>()
+    >;
+    using FieldTuple = std::tuple<Fields...>;
+    template <std::size_t I>
+    using FieldAt = std::tuple_element_t<I, FieldTuple>;
+
+    ContextType ctx;
+
+    constexpr TypedContext(const Fields&... fields) : ctx(fields.prof...) {
+        static_assert(
+            (std::is_same_v<typename Fields::member::struct_type, Struct> && ...),
+            "Every field must be a member pointer of the TypedContext struct"
+        );
+        std::size_t i = 0;
+        (verify_field<Fields>(ctx.ptable.static_profiles[i++]), ...);
+    }
+
+    private :
+    template <typename F>
+    static constexpr void verify_field(const profiles::static_profile& prof) {
+        using traits = typename F::traits;
+        // both need a RuntimeMapper (Fallbacks::attach, the child parse)
+        if(prof.env_key or prof.config_key)
+            throw except::comtime_except("Typed mode has no env / config fallbacks");
+        if(prof.is_subcommand())
+            throw except::comtime_except("Typed mode has no subcommands");
+        if constexpr (traits::is_flag) {
+            if((prof.narg == 0) and !prof.is_posarg) return;
+            if(prof.convert_code != traits::code)
+                throw except::comtime_except("bool field requires a profile without narg, or convert(codeBool)");
+        }
+        if(prof.convert_code != traits::code)
+            throw except::comtime_except("Field type is incompatible with profile convert code");
+        if(prof.narg > traits::capacity)
+            throw except::comtime_except("Field capacity is less than profile narg");
+    }
+};
+
+template <typename Struct, profiles::DenotedProfile... Prof, auto... Members>
+constexpr auto make_context(const Field<Members, Prof>&... fields) {
+    return TypedContext<Struct, Field<Members, Prof>...>(fields...);
+}
+
+namespace detail {
+
+template <typename F, std::size_t... Is>
+constexpr void visit_index(std::size_t idx, const F& func, std::index_sequence<Is...>) {
+    ((idx == Is ? (func(std::integral_constant<std::size_t, Is>{}), true) : false) || ...);
+}
+
+template <typename T>
+ParseErrc convert_token(std::string_view token, const profiles::static_profile& prof, T& out) noexcept {
+    if constexpr (std::is_same_v<T, StrT>) {
+        // argv entries (and their '=' tails) are null-terminated
+        if(token.data()[token.size()] != '\0') return ParseErrc::kNotNullTerminated;
+        out = token.data();
+        return ParseErrc::kNone;
+    } else if constexpr (std::is_same_v<T, BoolT>) {
+        return parser::convert_bool(token, out);
+    } else if constexpr (std::is_enum_v<T>) {
+        const dispatch::IndexT index = prof.choices.find(token);
+        if(index == dispatch::npos) return ParseErrc::kInvalidChoice;
+        out = static_cast<T>(index);
+        return ParseErrc::kNone;
+    } else {
+        return parser::convert_number(token, out);
+    }
+}
+
+// inserts one value into a field, false when the field is full
+template <typename Traits, typename M>
+bool insert(M& member, const profiles::static_profile& prof, std::size_t filled, std::string_view token, ParseErrc& ec) noexcept {
+    if(filled >= Traits::capacity) return false;
+    if constexpr (Traits::is_list) {
+        typename Traits::value_type buff{};
+        if((ec = convert_token(token, prof, buff)) != ParseErrc::kNone) return false;
+        member.push_back(buff);
+    } else {
+        if((ec = convert_token(token, prof, member)) != ParseErrc::kNone) return false;
+    }
+    return true;
+}
+
+template <typename M>
+void clear(M& member) noexcept {
+    if constexpr (field_traits<M>::is_list) member.clear();
+}
+
+}
+
+/*
+run_parse is the non-throwing core, follows the same rules as
+parser::run_parse (greedy consumption unless restricted,
+'-' tokens stop a value run, '=' gives exactly one value,
+-xvf clusters of short names)
+*/
+template <typename Struct, typename... Fields>
+parser::ParseFailure run_parse(
+    const TypedContext<Struct, Fields...>& tctx,
+    Struct& out,
+    const char** argv,
+    int argc
+) {
+    using Ctx = TypedContext<Struct, Fields...>;
+    constexpr std::size_t prof_count = sizeof...(Fields);
+    constexpr auto indices = std::make_index_sequence<prof_count>{};
+    const auto& smapper = tctx.ctx.mapper;
+    const auto& sprofs = tctx.ctx.ptable.static_profiles;
+    const auto& posargs = smapper.posargs;
+
+    parser::ParseFailure fail{};
+    constraint::BitSet<Ctx::id_count> called{};
+    std::array<WholeNumT, prof_count> calls{};
+    std::size_t posarg_i = 0;
+    std::size_t posarg_filled = 0;
+    int arg_i = 0;
+
+    auto fail_at = [&](ParseErrc ec, std::string_view token, const profiles::static_profile* prof) -> parser::ParseFailure& {
+        fail.set(ec, token, prof);
+        fail.token_index = parser::token_index_of(argv, argc, token);
+        if((ec == ParseErrc::kInvalidChoice) and prof) fail.known_names = prof->choices.hints;
+        return fail;
+    };
+
+    /*
+    one call of the option at idx, attached is its '=' value or the
+    rest of a cluster (one value), otherwise the next tokens are
+    taken when may_fetch. false with fail set
+    */
+    auto take_option = [&](std::size_t idx, std::string_view name, std::string_view attached, bool may_fetch) {
+        const profiles::static_profile& prof = sprofs[idx];
+        if(++calls[idx] > prof.call_limit) {
+            fail_at(ParseErrc::kCallLimit, name, &prof).detail = prof.call_limit;
+            return false;
+        }
+        called.set(idx);
+
+        std::string_view bad_token{};
+        ParseErrc ec = ParseErrc::kNone;
+        std::size_t filled = 0;
+
+        detail::visit_index(idx, [&](auto I) {
+            using F = typename Ctx::template FieldAt<decltype(I)::value>;
+            using traits = typename F::traits;
+            auto& member = out.*F::pointer;
+
+            if constexpr (traits::is_flag) {
+                if(!prof.narg) {
+                    member = true;
+                    return;
+                }
+            }
+
+            detail::clear(member);
+            if(!attached.empty()) {
+                if(detail::insert<traits>(member, prof, filled, attached, ec)) ++filled;
+                else if(ec != ParseErrc::kNone) bad_token = attached;
+                return;
+            }
+
+            const std::size_t limit = profiles::is_restricted(prof.behave) ? prof.narg : traits::capacity;
+            while(may_fetch and (filled < limit) and (arg_i < argc)) {
+                std::string_view value(argv[arg_i]);
+                if(value.empty() or (value[0] == '-')) break;
+                if(!detail::insert<traits>(member, prof, filled, value, ec)) {
+                    if(ec != ParseErrc::kNone) bad_token = value;
+                    break;
+                }
+                ++filled;
+                ++arg_i;
+            }
+        }, indices);
+
+        if(ec != ParseErrc::kNone) {
+            fail_at(ec, bad_token, &prof);
+            return false;
+        }
+        if(filled < prof.narg) {
+            fail_at(ParseErrc::kInsufficientNarg, name, &prof).detail = prof.narg - filled;
+            return false;
+        }
+        return true;
+    };
+
+    while(arg_i < argc) {
+        std::string_view token(argv[arg_i]);
+
+        if(token.empty() or (token[0] != '-') or parser::potential_digit(token.data())) {
+            bool stored = false;
+            while(!stored) {
+                if(posarg_i >= posargs.size())
+                    return fail_at(ParseErrc::kUnexpectedPosarg, token, nullptr);
+
+                const profiles::static_profile& prof = *posargs[posarg_i];
+                const std::size_t idx = smapper.profile_index(&prof);
+                ParseErrc ec = ParseErrc::kNone;
+                detail::visit_index(idx, [&](auto I) {
+                    using F = typename Ctx::template FieldAt<decltype(I)::value>;
+                    using traits = typename F::traits;
+                    auto& member = out.*F::pointer;
+
+                    // a bool posarg is a codeBool value (see verify_field)
+                    const std::size_t limit = profiles::is_restricted(prof.behave) ? prof.narg : traits::capacity;
+                    if(posarg_filled >= limit) return;
+                    if(!posarg_filled) detail::clear(member);
+                    if(detail::insert<traits>(member, prof, posarg_filled, token, ec)) {
+                        ++posarg_filled;
+                        stored = true;
+                    }
+                }, indices);
+
+                if(ec != ParseErrc::kNone)
+                    return fail_at(ec, token, &prof);
+                if(!stored) {
+                    ++posarg_i;
+                    posarg_filled = 0;
+                } else if(posarg_filled == 1) {
+                    // a posarg is called once, by its first token
+                    ++calls[idx];
+                    called.set(idx);
+                }
+            }
+            ++arg_i;
+            continue;
+        }
+
+        std::string_view name = token;
+        std::string_view eq_value{};
+        std::size_t eq_idx = token.find('=');
+        if(eq_idx != std::string_view::npos) {
+            eq_value = token.substr(eq_idx + 1);
+            name = token.substr(0, eq_idx);
+        }
+        ++arg_i;
+
+        dispatch::IndexT idx = smapper.dispatcher.find(name);
+        if(idx != dispatch::npos) {
+            if(!take_option(idx, name, eq_value, true)) return fail;
+            continue;
+        }
+
+        const bool single_dash = (name.size() > 2) and (name[1] != '-');
+        if(!single_dash) {
+            fail_at(ParseErrc::kUnknownFlag, name, nullptr).known_names = smapper.suggest_index.view();
+            return fail;
+        }
+
+        // a cluster of short names, the first member taking values gets the rest of the token
+        for(std::size_t i = 1; i < token.size(); i++) {
+            idx = smapper.short_table.find(token[i]);
+            if(idx == dispatch::npos) {
+                fail_at(ParseErrc::kUnknownFlag, token, nullptr).detail = i;
+                fail.known_names = smapper.suggest_index.view();
+                return fail;
+            }
+
+            const bool last = ((i + 1) == token.size());
+            if(last or sprofs[idx].narg) {
+                std::string_view attached = last ? std::string_view{} : token.substr(i + 1);
+                if(!attached.empty() and (attached[0] == '=')) attached.remove_prefix(1); // -xo=file as -o=file
+                if(!take_option(idx, token, attached, last)) return fail;
+                break;
+            }
+            if(!take_option(idx, token, std::string_view{}, false)) return fail;
+        }
+    }
+
+    if((posarg_i < posargs.size()) and (posarg_filled > 0) and (posarg_filled < posargs[posarg_i]->narg)) {
+        fail.set(ParseErrc::kInsufficientNarg, {}, posargs[posarg_i]).detail = posargs[posarg_i]->narg - posarg_filled;
+        return fail;
+    }
+
+    parser::check_constraints(smapper, called, fail);
+    return fail;
+}
+
+template <typename Struct, typename... Fields>
+void parse(const TypedContext<Struct, Fields...>& tctx, Struct& out, const char** argv, int argc) {
+    parser::ParseFailure fail = run_parse(tctx, out, argv, argc);
+    if(fail) parser::throw_failure(fail);
+}
+
+#ifdef __cpp_lib_expected
+template <typename Struct, typename... Fields>
+std::expected<void, parser::ParseFailure> try_parse(
+    const TypedContext<Struct, Fields...>& tctx,
+    Struct& out,
+    const char** argv,
+    int argc
+) {
+    parser::ParseFailure fail = run_parse(tctx, out, argv, argc);
+    if(fail) return std::unexpected(fail);
+    return {};
+}
+#endif
+
+}
+}
@@ -0,0 +1,260 @@
+#pragma once
+#include <cstddef>
+#include <cerrno>
+#include <array>
+#include <span>
+#include <string_view>
+
+#include <unistd.h>
+
+#include "commons.hpp"
+#include "utils.hpp"
+#include "values_experiment.hpp"
+#include "profiles.hpp"
+
+namespace sp {
+namespace usage {
+
+/*
+Compile-time help text
+
+HelpText renders the usage line and the help of a Context
+from its static_profiles (names, narg, convert code, required /
+restricted flags, call limit, exclusion points, fallback keys,
+posarg order, subcommands and .describe() text) during constant
+evaluation, into a std::array<char, N> stored in the binary.
+
+    static constexpr Context<...> ctx(
+        dnOpt()("--limit")["-l"].nargs(1).restricted().convert(codeInt).describe("max jobs"),
+        ...
+    );
+    using Help = usage::HelpText<ctx, "jobs">;
+    Help::write();           // one write(2) of Help::text
+    Help::view();            // or a std::string_view of it
+
+the Context must be a static constexpr object (it's taken as
+a const auto& template argument). printing involves no
+formatting, no allocation and no iostream.
+
+the layout :
+    usage: jobs [options] <pid> [<files>...]
+
+    arguments:
+      pid <int>              process id (required)
+    options:
+      -l, --limit <int>      max jobs (env JOBS_LIMIT)
+          --json             (not with --yaml)
+    commands:
+      list                   list the jobs
+*/
+
+using utils::FixedString;
+
+constexpr std::size_t kIndent = 2;
+constexpr std::size_t kMaxLeftColumn = 28; // longer entries put their description on the next line
+constexpr std::size_t kColumnGap = 2;
+
+constexpr std::string_view type_name(const TypeCodeT& code) noexcept {
+    if((code == values::type_code::kInt) or (code == values::type_code::kI64)) return "int";
+    if(code == values::type_code::kU64) return "uint";
+    if((code == values::type_code::kDob) or (code == values::type_code::kFlt)) return "num";
+    if(code == values::type_code::kStr) return "str";
+    if(code == values::type_code::kBool) return "bool";
+    return "value";
+}
+
+// counts the characters rendered
+struct Counter {
+    std::size_t size = 0;
+    constexpr void put(std::string_view str) noexcept { size += str.size(); }
+    constexpr void put(char) noexcept { ++size; }
+    constexpr void fill(char, std::size_t count) noexcept { size += count; }
+};
+
+template <std::size_t N>
+struct Writer {
+    std::array<char, N> buff{};
+    std::size_t size = 0;
+    constexpr void put(std::string_view str) noexcept { for(char c : str) buff[size++] = c; }
+    constexpr void put(char c) noexcept { buff[size++] = c; }
+    constexpr void fill(char c, std::size_t count) noexcept { while(count--) buff[size++] = c; }
+};
+
+template <typename Out>
+constexpr void put_number(Out& out, std::size_t val) {
+    char digits[20]{};
+    std::size_t len = 0;
+    do { digits[len++] = static_cast<char>('0' + (val % 10)); val /= 10; } while(val);
+    while(len) out.put(digits[--len]);
+}
+
+// "<int>", or the allowed words of a choice "<json|csv>"
+template <typename Out>
+constexpr void put_type(Out& out, const profiles::static_profile& prof) {
+    out.put('<');
+    if(prof.choices) {
+        for(std::size_t i = 0; i < prof.choices.words.size(); i++) {
+            if(i) out.put('|');
+            out.put(prof.choices.words[i]);
+        }
+    } else {
+        out.put(type_name(prof.convert_code));
+    }
+    out.put('>');
+}
+
+// " <int> <int>" for a restricted narg 2, " <int>..." when it takes more
+template <typename Out>
+constexpr void put_values(Out& out, const profiles::static_profile& prof) {
+    if(!prof.narg) return;
+    const std::size_t shown = profiles::is_restricted(prof.behave) ? prof.narg : 1;
+    for(std::size_t i = 0; i < shown; i++) {
+        out.put(' '); put_type(out, prof);
+    }
+    if(!profiles::is_restricted(prof.behave)) out.put("...");
+}
+
+template <typename Out>
+constexpr void put_left(Out& out, const profiles::static_profile& prof) {
+    if(prof.is_posarg or prof.is_subcommand()) {
+        out.put(prof.lname);
+    } else if(prof.sname and prof.lname) {
+        out.put(prof.sname); out.put(", "); out.put(prof.lname);
+    } else if(prof.sname) {
+        out.put(prof.sname);
+    } else {
+        out.put("    "); out.put(prof.lname); // lines up with "-x, --name"
+    }
+    put_values(out, prof);
+}
+
+constexpr std::size_t left_width(const profiles::static_profile& prof) {
+    Counter counter{};
+    put_left(counter, prof);
+    return counter.size;
+}
+
+template <typename Out>
+constexpr void put_attributes(Out& out, std::span<const profiles::static_profile> profs, const profiles::static_profile& prof) {
+    bool open = false;
+    auto next = [&]() {
+        out.put(open ? ", " : (prof.description ? " (" : "("));
+        open = true;
+    };
+
+    if(profiles::is_required(prof.behave)) { next(); out.put("required"); }
+    if(prof.call_limit > 1) { next(); out.put("up to "); put_number(out, prof.call_limit); out.put(" times"); }
+    if(prof.env_key) { next(); out.put("env "); out.put(prof.env_key); }
+    if(prof.config_key) { next(); out.put("config "); out.put(prof.config_key); }
+    if(prof.exclude_point >= 0) {
+        for(const profiles::static_profile& oth : profs) {
+            if((&oth == &prof) or (oth.exclude_point != prof.exclude_point)) continue;
+            next(); out.put("not with "); out.put(profiles::get_name(oth));
+        }
+    }
+    if(open) out.put(')');
+}
+
+template <typename Out>
+constexpr void put_entry(Out& out, std::span<const profiles::static_profile> profs, const profiles::static_profile& prof, std::size_t column) {
+    out.fill(' ', kIndent);
+    put_left(out, prof);
+    Counter right{};
+    if(prof.description) right.put(prof.description);
+    put_attributes(right, profs, prof);
+    if(!right.size) {
+        out.put('\n');
+        return;
+    }
+
+    const std::size_t width = left_width(prof);
+    if(width > column) {
+        out.put('\n');
+        out.fill(' ', kIndent + column + kColumnGap);
+    } else {
+        out.fill(' ', column - width + kColumnGap);
+    }
+    if(prof.description) out.put(prof.description);
+    put_attributes(out, profs, prof);
+    out.put('\n');
+}
+
+template <typename Out>
+constexpr void render(
+    Out& out,
+    std::span<const profiles::static_profile> profs,
+    std::span<const profiles::static_profile* const> posargs,
+    std::string_view prog
+) {
+    std::size_t column = 0;
+    bool any_option = false;
+    bool any_command = false;
+    for(const profiles::static_profile& prof : profs) {
+        const std::size_t width = left_width(prof);
+        if((width <= kMaxLeftColumn) and (width > column)) column = width;
+        any_command = any_command or prof.is_subcommand();
+        any_option = any_option or (!prof.is_posarg and !prof.is_subcommand());
+    }
+
+    out.put("usage: "); out.put(prog);
+    if(any_option) out.put(" [options]");
+    for(const profiles::static_profile* prof : posargs) {
+        const bool required = profiles::is_required(prof->behave);
+        out.put(required ? " <" : " [<"); out.put(prof->lname); out.put('>');
+        if(!profiles::is_restricted(prof->behave) or (prof->narg > 1)) out.put("...");
+        if(!required) out.put(']');
+    }
+    if(any_command) out.put(" <command> ...");
+    out.put('\n');
+
+    if(!posargs.empty()) {
+        out.put("\narguments:\n");
+        for(const profiles::static_profile* prof : posargs) put_entry(out, profs, *prof, column);
+    }
+    if(any_option) {
+        out.put("\noptions:\n");
+        for(const profiles::static_profile& prof : profs) {
+            if(!prof.is_posarg and !prof.is_subcommand()) put_entry(out, profs, prof, column);
+        }
+    }
+    if(any_command) {
+        out.put("\ncommands:\n");
+        for(const profiles::static_profile& prof : profs) {
+            if(prof.is_subcommand()) put_entry(out, profs, prof, column);
+        }
+    }
+}
+
+template <const auto& Ctx, FixedString Prog>
+struct HelpText {
+    static constexpr std::size_t length = []() {
+        Counter counter{};
+        render(counter, Ctx.ptable.static_profiles, Ctx.ptable.get_posargs(), Prog.view());
+        return counter.size;
+    }();
+
+    static constexpr std::array<char, length> text = []() {
+        Writer<length> writer{};
+        render(writer, Ctx.ptable.static_profiles, Ctx.ptable.get_posargs(), Prog.view());
+        return writer.buff;
+    }();
+
+    static constexpr std::string_view view() noexcept { return std::string_view(text.data(), length); }
+
+    // writes the whole text to fd (one write(2) unless it's interrupted or partial), false on error
+    static bool write(int fd = STDOUT_FILENO) noexcept {
+        std::size_t done = 0;
+        while(done < length) {
+            const ssize_t res = ::write(fd, text.data() + done, length - done);
+            if(res < 0) {
+                if(errno == EINTR) continue;
+                return false;
+            }
+            done += static_cast<std::size_t>(res);
+        }
+        return true;
+    }
+};
+
+}
+}
@@ -1,8 +1,22 @@
 #pragma once
+#include <cstddef>
 #include <array>
+#include <string_view>
 namespace sp {
 namespace utils {
 
+// a string literal as a template argument
+template <std::size_t N>
+struct FixedString {
+    char data[N]{};
+
+    constexpr FixedString(const char (&str)[N]) noexcept {
+        for(std::size_t i = 0; i < N; i++) data[i] = str[i];
+    }
+
+    constexpr std::string_view view() const noexcept { return std::string_view(data, N - 1); }
+};
+
 
 
 constexpr std::array<bool, 256> identifier_make_table(){
@@ -2,12 +2,15 @@
 
 #include <cstdint>
 #include <array>
-#include <iostream>
 #include <variant>
 #include <type_traits>
 #include <span>
 #include <functional>
 #include <bit>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
 
 #include "commons.hpp"
 #include "exceptions.hpp"
@@ -38,6 +41,12 @@ namespace type_code {
 	constexpr Tcode kInt = Tcode(0b1 << field_size) | ref_category;
 	constexpr Tcode kDob = Tcode(0b10 << field_size) | ref_category;
 	constexpr Tcode kStr = Tcode(0b100 << field_size) | ref_category;
+	// past the first three, the type field is a plain number
+	constexpr Tcode kI64 = Tcode(0b011 << field_size) | ref_category;
+	constexpr Tcode kU64 = Tcode(0b101 << field_size) | ref_category;
+	constexpr Tcode kFlt = Tcode(0b110 << field_size) | ref_category;
+	constexpr Tcode kBool = Tcode(0b111 << field_size) | ref_category;
+	constexpr Tcode kChoice = Tcode(0b1000 << field_size) | ref_category; // index of a choices() word
 
 	constexpr Tcode kRangedArr = Tcode(0b1 << field_size) |  arr_category;
 	constexpr Tcode kDynamicArr = Tcode(0b10 << field_size) | arr_category;
@@ -55,6 +64,11 @@ namespace type_code {
 			case kInt.value() : return "<INT_REF>";
 			case kDob.value() : return "<DOUBLE_REF>";
 			case kStr.value() : return "<STRING_REF>";
+			case kI64.value() : return "<INT64_REF>";
+			case kU64.value() : return "<UINT64_REF>";
+			case kFlt.value() : return "<FLOAT_REF>";
+			case kBool.value() : return "<BOOL_REF>";
+			case kChoice.value() : return "<CHOICE_REF>";
 			case kRangedArr.value() : return "<RANGED_ARRAY>";
 			case kDynamicArr.value() : return "<DYNAMIC_ARRAY>";
 			default : return "<UNKNOWN_TCODE>";
@@ -103,7 +117,193 @@ struct TrackingSpan {
 		return true;
 	}
 
+	std::size_t remaining() const noexcept { return viewer.size() - curr_idx; }
+
 	void track_reset() noexcept { curr_idx = 0; }
+
+	std::size_t mark() const noexcept { return curr_idx; }
+	void rewind(std::size_t at) noexcept { curr_idx = at; }
+};
+
+/*
+DynamicArr is the storage behind kDynamicArr,
+an unbounded list of Blob that grows (doubling) inside
+a caller supplied memory_resource, e.g. a
+std::pmr::monotonic_buffer_resource over a stack buffer.
+
+only O(log n) allocations are made from the resource
+for n values, never one per element
+
+constructed without a resource, it follows the resource
+of the RuntimeMapper / parse it's bound to (see adopt_resource)
+*/
+class DynamicArr {
+	private :
+	static_assert(std::is_trivially_copyable_v<Blob>, "DynamicArr relocates Blob with a plain copy");
+
+	std::pmr::memory_resource* resource;
+	bool follows_parse = false;
+	Blob* dat = nullptr;
+	std::size_t len = 0;
+	std::size_t cap = 0;
+
+	bool owns_storage = true; // false once the resource of the storage is parse-scoped, see disown_storage
+
+	void release() noexcept {
+		if(dat and owns_storage) resource->deallocate(dat, cap * sizeof(Blob), alignof(Blob));
+		dat = nullptr;
+		len = cap = 0;
+		owns_storage = true;
+	}
+
+	void grow() {
+		std::size_t new_cap = cap ? (cap * 2) : 16;
+		Blob* new_dat = static_cast<Blob*>(resource->allocate(new_cap * sizeof(Blob), alignof(Blob)));
+		if(dat) {
+			std::uninitialized_copy_n(dat, len, new_dat);
+			if(owns_storage) resource->deallocate(dat, cap * sizeof(Blob), alignof(Blob));
+		}
+		dat = new_dat;
+		cap = new_cap;
+		owns_storage = true;
+	}
+
+	public :
+	explicit DynamicArr(std::pmr::memory_resource* res = nullptr) noexcept
+		: resource(res ? res : default_resource()), follows_parse(!res) {}
+
+	DynamicArr(const DynamicArr&) = delete;
+	DynamicArr& operator=(const DynamicArr&) = delete;
+
+	~DynamicArr() { release(); }
+
+	/*
+	drops current storage and switches to res, unless an explicit
+	resource was given. also called with the same res, since the
+	caller may have released it (monotonic buffer per command line)
+	*/
+	void adopt_resource(std::pmr::memory_resource* res) noexcept {
+		if(!follows_parse or !res) return;
+		release();
+		resource = res;
+	}
+
+	/*
+	the storage came from a resource scoped to one parse
+	(parse(..., resource)), the values stay readable but the
+	storage is never given back to it : it's dropped as is on
+	the next adopt_resource, growth or destruction, since the
+	resource may be gone by then
+	*/
+	void disown_storage() noexcept {
+		if(follows_parse and dat) owns_storage = false;
+	}
+
+	template <typename T>
+	bool push_back(const T& val) {
+		if(len == cap) grow();
+		::new (static_cast<void*>(dat + len)) Blob(val);
+		++len;
+		return true;
+	}
+
+	void reserve(std::size_t n) { while(cap < n) grow(); }
+	void clear() noexcept { len = 0; }
+	// drops the values past n, storage is kept
+	void truncate(std::size_t n) noexcept { if(n < len) len = n; }
+
+	std::size_t size() const noexcept { return len; }
+	std::size_t capacity() const noexcept { return cap; }
+	std::pmr::memory_resource* get_resource() const noexcept { return resource; }
+	ArrT view() const noexcept { return ArrT(dat, len); }
+	Blob& operator[](std::size_t i) noexcept { return dat[i]; }
+	const Blob& operator[](std::size_t i) const noexcept { return dat[i]; }
+	Blob* begin() noexcept { return dat; }
+	Blob* end() noexcept { return dat + len; }
+	const Blob* begin() const noexcept { return dat; }
+	const Blob* end() const noexcept { return dat + len; }
+};
+
+struct TrackingDynamic {
+	DynamicArr* arr;
+	TrackingDynamic(DynamicArr& new_arr) : arr(&new_arr) {}
+
+	template <typename T>
+	bool push_back(const T& val) { return arr->push_back(val); }
+
+	std::size_t remaining() const noexcept { return std::numeric_limits<std::size_t>::max(); }
+
+	void track_reset() noexcept { arr->clear(); }
+
+	std::size_t mark() const noexcept { return arr->size(); }
+	void rewind(std::size_t at) noexcept { arr->truncate(at); }
+};
+
+/*
+LazyTokens is the parse side of values::Lazy (lazy.hpp),
+a kInt / kDob profile bound to it only records the views
+of its tokens (after a cheap syntactic check), they're
+converted the first time the value is read.
+
+the views point into the parsed tokens, which must outlive
+the reads, as for kStr values
+*/
+class LazyTokens {
+	private :
+	std::string_view* slots;
+	std::size_t cap;
+	std::size_t len = 0;
+	type_code::Tcode code;
+
+	protected :
+	mutable bool converted = false;
+
+	LazyTokens(std::string_view* storage, std::size_t capacity, type_code::Tcode value_code) noexcept
+		: slots(storage), cap(capacity), code(value_code) {}
+
+	public :
+	LazyTokens(const LazyTokens&) = delete;
+	LazyTokens& operator=(const LazyTokens&) = delete;
+
+	bool push_back(std::string_view token) noexcept {
+		if(len >= cap)
+			return false;
+		slots[len++] = token;
+		converted = false;
+		return true;
+	}
+
+	std::size_t size() const noexcept { return len; }
+	std::size_t capacity() const noexcept { return cap; }
+	std::size_t remaining() const noexcept { return cap - len; }
+	type_code::Tcode value_code() const noexcept { return code; }
+	std::span<const std::string_view> tokens() const noexcept { return std::span<const std::string_view>(slots, len); }
+
+	void track_reset() noexcept {
+		len = 0;
+		converted = false;
+	}
+
+	// drops the tokens past n
+	void truncate(std::size_t n) noexcept {
+		if(n >= len) return;
+		len = n;
+		converted = false;
+	}
+};
+
+struct TrackingLazy {
+	LazyTokens* lazy;
+	TrackingLazy(LazyTokens& tokens) : lazy(&tokens) {}
+
+	bool push_back(std::string_view token) noexcept { return lazy->push_back(token); }
+
+	std::size_t remaining() const noexcept { return lazy->remaining(); }
+
+	void track_reset() noexcept { lazy->track_reset(); }
+
+	std::size_t mark() const noexcept { return lazy->size(); }
+	void rewind(std::size_t at) noexcept { lazy->truncate(at); }
 };
 
 template <typename T>
@@ -125,11 +325,45 @@ struct TrackingReference : public std::reference_wrapper<T> {
 	}
 
 	void track_reset() noexcept { filled = false; }
+
+	std::size_t mark() const noexcept { return filled; }
+	void rewind(std::size_t at) noexcept { filled = (at != 0); }
 };
 
 using IntRef = TrackingReference<IntT>;
 using DobRef = TrackingReference<DobT>;
 using StrRef = TrackingReference<StrT>;
+using I64Ref = TrackingReference<I64T>;
+using U64Ref = TrackingReference<U64T>;
+using FltRef = TrackingReference<FltT>;
+using BoolRef = TrackingReference<BoolT>;
+
+/*
+ChoiceRef is the binding of a kChoice profile, an enum
+receiving the index of the word given (its position in
+the profile's ChoiceSet, see choice.hpp)
+*/
+struct ChoiceRef {
+	void* target = nullptr;
+	void (*store)(void* target, IntT index) = nullptr;
+	bool filled = false;
+
+	template <typename E>
+	ChoiceRef(E& var) noexcept
+		: target(&var), store([](void* dst, IntT index) { *static_cast<E*>(dst) = static_cast<E>(index); }) {}
+
+	bool insert(IntT index) noexcept {
+		if(filled)
+			return false;
+		store(target, index);
+		return (filled = true);
+	}
+
+	void track_reset() noexcept { filled = false; }
+
+	std::size_t mark() const noexcept { return filled; }
+	void rewind(std::size_t at) noexcept { filled = (at != 0); }
+};
 
 template <typename T>
 struct to_ref {
@@ -137,24 +371,32 @@ struct to_ref {
 };
 
 template <typename GetType, typename VariantType>
-GetType& ce_get(VariantType& ins, std::string_view error_msg) {  // Custom Error
+GetType& ce_get(VariantType& ins, const char* error_msg) {  // Custom Error
 	if(std::holds_alternative<GetType>(ins))
 		return std::get<GetType>(ins);
-	else 
-		throw std::invalid_argument(("(Discriminator : " + std::to_string(ins.index()) + ") ").append(error_msg));
+#ifdef STATIC_PARSER_NO_HEAP
+	throw except::ParseError(error_msg);
+#else
+	throw std::invalid_argument(("(Discriminator : " + std::to_string(ins.index()) + ") ").append(error_msg));
+#endif
 }
 
 class BoundValue {
 	private :
 
-	using ConsumeF = std::function<bool(void* val, type_code::Tcode)>;
-
 	using val_type = std::variant<
 		std::monostate,
 		IntRef,
 		DobRef,
 		StrRef,
-		TrackingSpan
+		TrackingSpan,
+		TrackingDynamic,
+		TrackingLazy,
+		I64Ref,
+		U64Ref,
+		FltRef,
+		BoolRef,
+		ChoiceRef
 	>;
 
 	val_type value;
@@ -178,6 +420,34 @@ class BoundValue {
 			case 4 :
 				std::get<std::variant_alternative_t<4, val_type>>(value).track_reset();
 				break;
+
+			case 5 :
+				std::get<std::variant_alternative_t<5, val_type>>(value).track_reset();
+				break;
+
+			case 6 :
+				std::get<std::variant_alternative_t<6, val_type>>(value).track_reset();
+				break;
+
+			case 7 :
+				std::get<std::variant_alternative_t<7, val_type>>(value).track_reset();
+				break;
+
+			case 8 :
+				std::get<std::variant_alternative_t<8, val_type>>(value).track_reset();
+				break;
+
+			case 9 :
+				std::get<std::variant_alternative_t<9, val_type>>(value).track_reset();
+				break;
+
+			case 10 :
+				std::get<std::variant_alternative_t<10, val_type>>(value).track_reset();
+				break;
+
+			case 11 :
+				std::get<std::variant_alternative_t<11, val_type>>(value).track_reset();
+				break;
 		}
 	}
 
@@ -205,24 +475,69 @@ class BoundValue {
 				.insert(*reinterpret_cast<DobT*>(var));
 	}
 
-	static bool fill_arr(void* var, type_code::Tcode code, BoundValue& ins) {
-		if(!var) 
-			throw except::ParseError("fill_arr : \"var\" argument is a nullptr");
+	// the wider references (kI64, kU64, kFlt, kBool, kChoice)
+	template <typename RefT, typename T, std::uint8_t Code>
+	static bool fill_ref(void* var, type_code::Tcode code, BoundValue& ins) {
+		if(!var || (code.value() != Code))
+			throw except::ParseError("fill_ref : invalid argument");
 
-		TrackingSpan& arr = 
-			ce_get<TrackingSpan>(ins.value, "fill_arr : get failed");
+		return ce_get<RefT>(ins.value, "fill_ref : get failed")
+				.insert(*reinterpret_cast<T*>(var));
+	}
 
+	// Blob of a value of code, kChoice values are their IntT index
+	static bool push_blob(auto& arr, void* var, type_code::Tcode code, bool& known) {
+		known = true;
 		switch (code.value())
 		{
 		case type_code::kInt.value() : return arr.push_back(*reinterpret_cast<IntT*>(var));
 		case type_code::kDob.value() : return arr.push_back(*reinterpret_cast<DobT*>(var));
 		case type_code::kStr.value() : return arr.push_back(*reinterpret_cast<StrT*>(var));
-		default: throw except::ParseError(
-			(std::string("fill_arr : type_code of ") +
+		case type_code::kI64.value() : return arr.push_back(*reinterpret_cast<I64T*>(var));
+		case type_code::kU64.value() : return arr.push_back(*reinterpret_cast<U64T*>(var));
+		case type_code::kFlt.value() : return arr.push_back(*reinterpret_cast<FltT*>(var));
+		case type_code::kBool.value() : return arr.push_back(*reinterpret_cast<BoolT*>(var));
+		case type_code::kChoice.value() : return arr.push_back(*reinterpret_cast<IntT*>(var));
+		default : return (known = false);
+		}
+	}
+
+	[[noreturn]] static void unacceptable_code([[maybe_unused]] const char* where, [[maybe_unused]] type_code::Tcode code) {
+#ifdef STATIC_PARSER_NO_HEAP
+		throw except::ParseError("fill_arr / fill_dyn : type_code is unacceptable");
+#else
+		throw except::ParseError(
+			(std::string(where) + " : type_code of " +
 			type_code::code_to_str(code)) +
 			" Is unacceptable"
 		);
-		}
+#endif
+	}
+
+	static bool fill_arr(void* var, type_code::Tcode code, BoundValue& ins) {
+		if(!var) 
+			throw except::ParseError("fill_arr : \"var\" argument is a nullptr");
+
+		TrackingSpan& arr = 
+			ce_get<TrackingSpan>(ins.value, "fill_arr : get failed");
+
+		bool known = false;
+		const bool res = push_blob(arr, var, code, known);
+		if(!known) unacceptable_code("fill_arr", code);
+		return res;
+	}
+
+	static bool fill_dyn(void* var, type_code::Tcode code, BoundValue& ins) {
+		if(!var) 
+			throw except::ParseError("fill_dyn : \"var\" argument is a nullptr");
+
+		TrackingDynamic& arr = 
+			ce_get<TrackingDynamic>(ins.value, "fill_dyn : get failed");
+
+		bool known = false;
+		const bool res = push_blob(arr, var, code, known);
+		if(!known) unacceptable_code("fill_dyn", code);
+		return res;
 	}
 
 	static bool fill_fail(void*, type_code::Tcode, BoundValue&) { return false; }
@@ -239,25 +554,28 @@ class BoundValue {
 			fill_method = fill_str;
 		else if constexpr (std::is_same_v<T, TrackingSpan>)
 			fill_method = fill_arr;
+		else if constexpr (std::is_same_v<T, TrackingDynamic>)
+			fill_method = fill_dyn;
+		else if constexpr (std::is_same_v<T, I64Ref>)
+			fill_method = fill_ref<I64Ref, I64T, type_code::kI64.value()>;
+		else if constexpr (std::is_same_v<T, U64Ref>)
+			fill_method = fill_ref<U64Ref, U64T, type_code::kU64.value()>;
+		else if constexpr (std::is_same_v<T, FltRef>)
+			fill_method = fill_ref<FltRef, FltT, type_code::kFlt.value()>;
+		else if constexpr (std::is_same_v<T, BoolRef>)
+			fill_method = fill_ref<BoolRef, BoolT, type_code::kBool.value()>;
+		else if constexpr (std::is_same_v<T, ChoiceRef>)
+			fill_method = fill_ref<ChoiceRef, IntT, type_code::kChoice.value()>;
+		else if constexpr (std::is_same_v<T, TrackingLazy>)
+			fill_method = fill_fail; // tokens are recorded by the parser, nothing is converted
 		else 
 			throw except::SetupError("Unsupported type set_fill_method failed");
 	}
 
-	template <typename T>
-	std::size_t consume_amnt_impl() const noexcept { return 0; }
-
-	template<typename T>
-	std::size_t consume_amnt_impl<typename to_ref<T>::type>() const noexcept {
-		return 1;
-	}
-
-	template <>
-	std::size_t consume_amnt_impl<TrackingSpan>() const noexcept {
-		return std::get<TrackingSpan>(this->value).viewer.size();
-	}
-
 	public :
 
+	void track_reset() { this->reset(); }
+
 	auto opc() { // open parsing context
 		this->reset();
 		return [&](void* val, type_code::Tcode code) -> bool {
@@ -268,8 +586,8 @@ class BoundValue {
 	template <typename T>
 	typename std::enable_if_t<is_within_variant<typename to_ref<T>::type, val_type>::value, void>
 	bind(T& ref) {
-		this->value = std::ref(ref);
-		set_fill_method<to_ref<T>::type>();
+		this->value = typename to_ref<T>::type{ std::ref(ref) };
+		set_fill_method<typename to_ref<T>::type>();
 	}
 
 	void bind(ArrT arr) {
@@ -277,10 +595,57 @@ class BoundValue {
 		set_fill_method<TrackingSpan>();
 	}
 
-	std::size_t consume_amnt() const {
+	void bind(DynamicArr& arr) {
+		this->value = TrackingDynamic(arr);
+		set_fill_method<TrackingDynamic>();
+	}
+
+	template <typename E>
+	typename std::enable_if_t<std::is_enum_v<E>, void>
+	bind(E& var) {
+		this->value = ChoiceRef(var);
+		set_fill_method<ChoiceRef>();
+	}
+
+	void bind(LazyTokens& lazy) {
+		this->value = TrackingLazy(lazy);
+		set_fill_method<TrackingLazy>();
+	}
+
+	std::size_t consume_amnt() const noexcept {
+		switch(value.index()) {
+			case 0 : return 0;
+			case 4 : return std::get<TrackingSpan>(value).viewer.size();
+			case 5 : return std::numeric_limits<std::size_t>::max();
+			case 6 : return std::get<TrackingLazy>(value).lazy->capacity();
+			default : return 1;
+		}
+	}
+
+	/*
+	cursor of the bound value (values taken / filled) and its
+	restoration, values past the cursor are dropped, the ones
+	before it are left as they are (see incremental.hpp)
+	*/
+	std::size_t mark() const noexcept {
+		return std::visit([](const auto& arg) -> std::size_t {
+			if constexpr (std::is_same_v<std::decay_t<decltype(arg)>, std::monostate>) return 0;
+			else return arg.mark();
+		}, value);
+	}
 
+	void rewind(std::size_t at) noexcept {
+		std::visit([at](auto& arg) {
+			if constexpr (!std::is_same_v<std::decay_t<decltype(arg)>, std::monostate>) arg.rewind(at);
+		}, value);
 	}
 
+	template <typename T>
+	T* get_if() noexcept { return std::get_if<T>(&value); }
+
+	template <typename T>
+	T& get_value() { return ce_get<T>(value, "get_value : BoundValue doesn't hold the requested type"); }
+
 
 	values::type_code::Tcode get_code() {
 		return std::visit([](auto&& arg) {
@@ -290,6 +655,13 @@ class BoundValue {
 			if constexpr (std::is_same_v<T, DobRef>) return values::type_code::kDob;
 			if constexpr (std::is_same_v<T, StrRef>) return values::type_code::kStr;
 			if constexpr (std::is_same_v<T, TrackingSpan>) return values::type_code::kRangedArr;
+			if constexpr (std::is_same_v<T, TrackingDynamic>) return values::type_code::kDynamicArr;
+			if constexpr (std::is_same_v<T, TrackingLazy>) return arg.lazy->value_code();
+			if constexpr (std::is_same_v<T, I64Ref>) return values::type_code::kI64;
+			if constexpr (std::is_same_v<T, U64Ref>) return values::type_code::kU64;
+			if constexpr (std::is_same_v<T, FltRef>) return values::type_code::kFlt;
+			if constexpr (std::is_same_v<T, BoolRef>) return values::type_code::kBool;
+			if constexpr (std::is_same_v<T, ChoiceRef>) return values::type_code::kChoice;
 			else return values::type_code::Tcode();
 		}, this->value);
 	}
@@ -301,5 +673,11 @@ using TypeCodeT = values::type_code::Tcode;
 const TypeCodeT& codeStr = values::type_code::kStr;
 const TypeCodeT& codeInt = values::type_code::kInt;
 const TypeCodeT& codeDob = values::type_code::kDob;
+const TypeCodeT& codeI64 = values::type_code::kI64;
+const TypeCodeT& codeU64 = values::type_code::kU64;
+const TypeCodeT& codeFlt = values::type_code::kFlt;
+const TypeCodeT& codeBool = values::type_code::kBool;
+const TypeCodeT& codeChoice = values::type_code::kChoice;
 const TypeCodeT& codeArr = values::type_code::kRangedArr;
+const TypeCodeT& codeDynArr = values::type_code::kDynamicArr;
 }
\ No newline at end of file
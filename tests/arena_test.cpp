@@ -0,0 +1,171 @@
+/*
+parse(rmap, argv, argc, resource) : nothing reaches operator new
+while parsing on a caller arena (positional spill, DynamicArr growth,
+error text), the mapper gets its previous resource back and the
+arena is never used again once the parse returned (it may be gone
+before the next reset or the DynamicArr destruction)
+*/
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <memory_resource>
+
+#include "ArgParser/static_parser.hpp"
+#include "check.hpp"
+
+namespace {
+
+std::atomic<bool> g_armed{false};
+std::atomic<std::size_t> g_armed_allocs{0};
+
+}
+
+void* operator new(std::size_t size) {
+    if(g_armed.load(std::memory_order_relaxed)) g_armed_allocs.fetch_add(1, std::memory_order_relaxed);
+    if(void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace {
+
+using namespace sp;
+
+static constexpr Context<3, 2, 1> ctx(
+    dnOpt()("--jobs")["-j"].nargs(1).restricted().convert(codeInt),
+    posArg()("files").nargs(1).convert(codeStr)
+);
+
+alignas(std::max_align_t) unsigned char g_buffer[16 * 1024];
+
+// a per command line arena, calls after close() would reach a destroyed one
+class LineArena : public std::pmr::memory_resource {
+    std::pmr::monotonic_buffer_resource arena;
+    bool closed = false;
+
+    void* do_allocate(std::size_t bytes, std::size_t align) override {
+        if(closed) ++late_calls;
+        return arena.allocate(bytes, align);
+    }
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t align) override {
+        if(closed) ++late_calls;
+        arena.deallocate(ptr, bytes, align);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    public :
+    std::size_t late_calls = 0;
+
+    LineArena() : arena(g_buffer, sizeof(g_buffer), std::pmr::null_memory_resource()) {}
+    void close() noexcept { closed = true; }
+};
+
+struct Bindings {
+    std::array<ModProf, 2> mprofs{};
+    IntT jobs = 0;
+    DynamicArr files;
+    mapper::RuntimeMapper<3> rmap{ ctx.mapper, mprofs };
+
+    Bindings() {
+        mprofs[0].bind(jobs);
+        mprofs[1].bind(files);
+        rmap.verify();
+    }
+};
+
+const char* g_files[] = { "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m", "n", "o", "p", "q", "r" };
+
+// runs parse_once armed, returns the operator new calls it made
+template <typename ParseF>
+std::size_t armed_allocs(const ParseF& parse_once) {
+    g_armed_allocs.store(0, std::memory_order_relaxed);
+    g_armed.store(true, std::memory_order_relaxed);
+    parse_once();
+    g_armed.store(false, std::memory_order_relaxed);
+    return g_armed_allocs.load(std::memory_order_relaxed);
+}
+
+}
+
+int main() {
+    std::pmr::monotonic_buffer_resource arena(g_buffer, sizeof(g_buffer), std::pmr::null_memory_resource());
+
+    std::array<ModProf, 2> mprofs{};
+    IntT jobs = 0;
+    DynamicArr files;
+    mprofs[0].bind(jobs);
+    mprofs[1].bind(files);
+    mapper::RuntimeMapper<3> rmap(ctx.mapper, mprofs);
+    rmap.verify();
+    std::pmr::memory_resource* const previous = rmap.get_resource();
+
+    // more files than the inline positional index
+    const char* success[] = {
+        "a", "b", "c", "d", "e", "f", "g", "h", "i", "j",
+        "k", "l", "m", "n", "o", "p", "q", "r", "s", "t", "-j", "8"
+    };
+    CHECK(armed_allocs([&]() { parser::parse(rmap, success, static_cast<int>(std::size(success)), &arena); }) == 0);
+    CHECK((jobs == 8) and (files.size() == 20));
+    CHECK(rmap.get_resource() == previous);
+    // the values of the parse stay in the arena until the next reset
+    CHECK(files.get_resource() == &arena);
+    CHECK(std::string_view(std::get<StrT>(files[19])) == "t");
+
+    rmap.reset();
+    CHECK(files.get_resource() == previous);
+
+    arena.release();
+    const char* unknown[] = { "--jbos", "4" };
+    bool thrown = false;
+    CHECK(armed_allocs([&]() {
+        try {
+            parser::parse(rmap, unknown, 2, &arena);
+        } catch(const except::ParseError& err) {
+            thrown = (err.what()[0] != '\0');
+        }
+    }) == 0);
+    CHECK(thrown);
+    CHECK(rmap.get_resource() == previous);
+
+    {
+        // the arena is done with before the reset
+        Bindings bind;
+        LineArena line;
+        parser::parse(bind.rmap, g_files, static_cast<int>(std::size(g_files)), &line);
+        CHECK((bind.files.size() == 18) and (bind.files.get_resource() == &line));
+        line.close();
+        bind.rmap.reset();
+        CHECK((line.late_calls == 0) and (bind.files.get_resource() == previous));
+        parser::parse(bind.rmap, g_files, 3);
+        CHECK((bind.files.size() == 3) and (line.late_calls == 0));
+    }
+
+    {
+        // and before the DynamicArr is destroyed
+        LineArena line;
+        {
+            Bindings bind;
+            parser::parse(bind.rmap, g_files, static_cast<int>(std::size(g_files)), &line);
+            line.close();
+        }
+        CHECK(line.late_calls == 0);
+    }
+
+    {
+        // a real scope, a use of the arena after it is caught by ASan (see run.sh)
+        Bindings bind;
+        {
+            std::pmr::monotonic_buffer_resource scoped(g_buffer, sizeof(g_buffer), std::pmr::null_memory_resource());
+            parser::parse(bind.rmap, g_files, static_cast<int>(std::size(g_files)), &scoped);
+            CHECK(std::string_view(std::get<StrT>(bind.files[17])) == "r");
+        }
+        bind.rmap.reset();
+    }
+
+    return check::result("arena");
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdio>
+
+/*
+assertion helpers of the functional tests (see run.sh),
+a failed CHECK prints its location and the test goes on,
+main returns check::result()
+*/
+
+namespace check {
+
+inline int failures = 0;
+
+inline void fail(const char* file, int line, const char* expr) {
+    std::printf("%s:%d: CHECK(%s) failed\n", file, line, expr);
+    ++failures;
+}
+
+inline int result(const char* name) {
+    std::printf("%-28s %s\n", name, failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
+
+}
+
+#define CHECK(...) do { if(!(__VA_ARGS__)) check::fail(__FILE__, __LINE__, #__VA_ARGS__); } while(0)
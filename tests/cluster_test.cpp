@@ -0,0 +1,109 @@
+/*
+short name clusters : flags are set one by one, the first
+member taking values gets the rest of the token (-vofile,
+-vn5) or the next tokens when it's the last member (-xvf file)
+*/
+#include <array>
+#include <string_view>
+
+#include "ArgParser/static_parser.hpp"
+#include "check.hpp"
+
+namespace {
+
+using namespace sp;
+
+static constexpr Context<10, 5, 0> ctx(
+    dnOpt()("--extract")["-x"],
+    dnOpt()("--verbose")["-v"],
+    dnOpt()("--file")["-f"].nargs(1).restricted().convert(codeStr),
+    dnOpt()("--output")["-o"].nargs(1).restricted().convert(codeStr),
+    dnOpt()("--level")["-n"].nargs(1).restricted().convert(codeInt)
+);
+
+struct Bindings {
+    std::array<ModProf, 5> mprofs{};
+    StrT file = nullptr;
+    StrT output = nullptr;
+    IntT level = 0;
+    mapper::RuntimeMapper<10> rmap{ ctx.mapper, mprofs };
+
+    Bindings() {
+        mprofs[2].bind(file);
+        mprofs[3].bind(output);
+        mprofs[4].bind(level);
+        rmap.verify();
+    }
+
+    bool called(std::size_t idx) const { return rmap.called_set().test(idx); }
+};
+
+template <std::size_t N>
+parser::ParseFailure run(Bindings& bind, const char* (&argv)[N]) {
+    bind.rmap.reset();
+    return parser::run_parse(bind.rmap, argv, static_cast<int>(N));
+}
+
+}
+
+int main() {
+    Bindings bind;
+
+    {
+        const char* argv[] = { "-xvf", "archive.tar" };
+        CHECK(!run(bind, argv));
+        CHECK(bind.called(0) and bind.called(1) and bind.called(2));
+        CHECK(std::string_view(bind.file) == "archive.tar");
+    }
+
+    {
+        const char* argv[] = { "-vofile" };
+        CHECK(!run(bind, argv));
+        CHECK(bind.called(1) and !bind.called(0));
+        CHECK(std::string_view(bind.output) == "file");
+    }
+
+    {
+        const char* argv[] = { "-vn5" };
+        CHECK(!run(bind, argv));
+        CHECK(bind.called(1) and (bind.level == 5));
+    }
+
+    {
+        // -xo=file as -o=file
+        const char* argv[] = { "-xo=out.txt" };
+        CHECK(!run(bind, argv));
+        CHECK(bind.called(0) and (std::string_view(bind.output) == "out.txt"));
+    }
+
+    {
+        // a lone short name with a negative value, through '='
+        const char* argv[] = { "-n=-3", "-x" };
+        CHECK(!run(bind, argv));
+        CHECK((bind.level == -3) and bind.called(0));
+    }
+
+    {
+        // detail is the index of the unknown member in the token
+        const char* argv[] = { "-xqv" };
+        const parser::ParseFailure fail = run(bind, argv);
+        CHECK(fail.code == ParseErrc::kUnknownFlag);
+        CHECK((fail.token_index == 0) and (fail.detail == 2));
+    }
+
+    {
+        const char* argv[] = { "-vn", "x5" };
+        const parser::ParseFailure fail = run(bind, argv);
+        CHECK(fail.code == ParseErrc::kNotANumber);
+        CHECK(fail.token_index == 1);
+    }
+
+    {
+        const char* argv[] = { "-xf" };
+        const parser::ParseFailure fail = run(bind, argv);
+        CHECK(fail.code == ParseErrc::kInsufficientNarg);
+        CHECK((fail.profile != nullptr) and (std::string_view(profiles::get_name(*fail.profile)) == "--file"));
+    }
+
+    return check::result("cluster");
+}
@@ -0,0 +1,134 @@
+/*
+constraints checked while parsing (call limits) and at the
+end of the parse (required profiles, exclusion groups)
+*/
+#include <array>
+#include <string_view>
+
+#include "ArgParser/static_parser.hpp"
+#include "check.hpp"
+
+namespace {
+
+using namespace sp;
+
+static constexpr Context<8, 7, 0> ctx(
+    snOpt()("--name").nargs(1).restricted().convert(codeStr).required(),
+    snOpt()("--json").exclude(0),
+    snOpt()("--yaml").exclude(0),
+    snOpt()("--fast").exclude(1),
+    snOpt()("--safe").exclude(1),
+    snOpt()("--tag").nargs(1).convert(codeStr).call_lim(3),
+    dnOpt()("--verbose")["-v"].call_lim(2)
+);
+
+struct Bindings {
+    std::array<ModProf, 7> mprofs{};
+    StrT name = nullptr;
+    std::array<Blob, 4> tag_storage{};
+    ArrT tags{ tag_storage };
+    mapper::RuntimeMapper<8> rmap{ ctx.mapper, mprofs };
+
+    Bindings() {
+        mprofs[0].bind(name);
+        mprofs[5].bind(tags);
+        rmap.verify();
+    }
+};
+
+template <std::size_t N>
+parser::ParseFailure run(Bindings& bind, const char* (&argv)[N]) {
+    bind.rmap.reset();
+    return parser::run_parse(bind.rmap, argv, static_cast<int>(N));
+}
+
+std::string_view name_of(const parser::ParseFailure& fail) {
+    return fail.profile ? std::string_view(profiles::get_name(*fail.profile)) : std::string_view{};
+}
+
+std::string_view message(const parser::ParseFailure& fail, char (&buf)[256]) {
+    fail.format(buf);
+    return buf;
+}
+
+}
+
+int main() {
+    Bindings bind;
+    char msg[256];
+
+    {
+        // one of each exclusion group is fine
+        const char* argv[] = { "--name", "x", "--json", "--safe", "--tag", "a", "--tag", "b", "--tag", "c", "-vv" };
+        CHECK(!run(bind, argv));
+        CHECK(std::string_view(std::get<StrT>(bind.tag_storage[0])) == "c");
+    }
+
+    {
+        const char* argv[] = { "--json", "--tag", "a" };
+        const parser::ParseFailure fail = run(bind, argv);
+        CHECK(fail.code == ParseErrc::kRequiredMissing);
+        CHECK((name_of(fail) == "--name") and (fail.token_index == parser::ParseFailure::npos));
+        CHECK(message(fail, msg) == "A required option of \"--name\" was not called");
+    }
+
+    {
+        const char* argv[] = { "--yaml", "--name", "x", "--json" };
+        const parser::ParseFailure fail = run(bind, argv);
+        CHECK(fail.code == ParseErrc::kExcluded);
+        CHECK((name_of(fail) == "--yaml") and (fail.token == "--json"));
+        CHECK(message(fail, msg) == "--yaml can't be used with --json");
+    }
+
+    {
+        const char* argv[] = { "--name", "x", "--fast", "--safe" };
+        const parser::ParseFailure fail = run(bind, argv);
+        CHECK(fail.code == ParseErrc::kExcluded);
+        CHECK((name_of(fail) == "--safe") and (fail.token == "--fast"));
+    }
+
+    {
+        /*
+        default call limit is 1. the repeated name is spelled
+        differently, equal literals may share storage and
+        token_index would then point at the first one
+        */
+        const char* argv[] = { "--name", "x", "--name=y" };
+        const parser::ParseFailure fail = run(bind, argv);
+        CHECK(fail.code == ParseErrc::kCallLimit);
+        CHECK((name_of(fail) == "--name") and (fail.detail == 1) and (fail.token_index == 2));
+        CHECK(message(fail, msg) == "--name can't be called more than 1 time");
+    }
+
+    {
+        const char* argv[] = { "--name", "x", "--tag", "a", "--tag", "b", "--tag", "c", "--tag=d" };
+        const parser::ParseFailure fail = run(bind, argv);
+        CHECK(fail.code == ParseErrc::kCallLimit);
+        CHECK((name_of(fail) == "--tag") and (fail.detail == 3) and (fail.token_index == 8));
+        CHECK(message(fail, msg) == "--tag can't be called more than 3 times");
+    }
+
+    {
+        // each member of a cluster is a call
+        const char* argv[] = { "--name", "x", "-vvv" };
+        const parser::ParseFailure fail = run(bind, argv);
+        CHECK(fail.code == ParseErrc::kCallLimit);
+        CHECK((name_of(fail) == "--verbose") and (fail.detail == 2) and (fail.token_index == 2));
+    }
+
+    {
+        const char* argv[] = { "--verbose", "--name", "x", "-vv" };
+        const parser::ParseFailure fail = run(bind, argv);
+        CHECK(fail.code == ParseErrc::kCallLimit);
+        CHECK(fail.token_index == 3);
+    }
+
+    {
+        // the call counts start over on reset
+        const char* argv[] = { "--name", "y", "-v", "--verbose" };
+        CHECK(!run(bind, argv));
+        CHECK(std::string_view(bind.name) == "y");
+    }
+
+    return check::result("constraint");
+}
@@ -0,0 +1,142 @@
+/*
+value conversions : choice words to an enum (kInvalidChoice
+suggests the closest words), boolean words, and the fixed
+width numbers
+*/
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+#include "ArgParser/static_parser.hpp"
+#include "check.hpp"
+
+namespace {
+
+using namespace sp;
+
+static constexpr choice::ChoiceSet formats{ "json", "csv", "tsv", "binary" };
+enum class Format { kJson, kCsv, kTsv, kBinary };
+
+static constexpr Context<6, 6, 0> ctx(
+    snOpt()("--format").nargs(1).restricted().choices(formats),
+    snOpt()("--color").nargs(1).restricted().convert(codeBool),
+    snOpt()("--offset").nargs(1).restricted().convert(codeI64),
+    snOpt()("--size").nargs(1).restricted().convert(codeU64),
+    snOpt()("--scale").nargs(1).restricted().convert(codeFlt),
+    snOpt()("--level").nargs(1).restricted().convert(codeInt)
+);
+
+struct Bindings {
+    std::array<ModProf, 6> mprofs{};
+    Format format = Format::kJson;
+    BoolT color = false;
+    I64T offset = 0;
+    U64T size = 0;
+    FltT scale = 0;
+    IntT level = 0;
+    mapper::RuntimeMapper<6> rmap{ ctx.mapper, mprofs };
+
+    Bindings() {
+        mprofs[0].bind(format);
+        mprofs[1].bind(color);
+        mprofs[2].bind(offset);
+        mprofs[3].bind(size);
+        mprofs[4].bind(scale);
+        mprofs[5].bind(level);
+        rmap.verify();
+    }
+};
+
+template <std::size_t N>
+parser::ParseFailure run(Bindings& bind, const char* (&argv)[N]) {
+    bind.rmap.reset();
+    return parser::run_parse(bind.rmap, argv, static_cast<int>(N));
+}
+
+std::string_view message(const parser::ParseFailure& fail, char (&buf)[256]) {
+    fail.format(buf);
+    return buf;
+}
+
+}
+
+int main() {
+    Bindings bind;
+    char msg[256];
+
+    {
+        const char* argv[] = { "--format", "tsv" };
+        CHECK(!run(bind, argv));
+        CHECK(bind.format == Format::kTsv);
+    }
+
+    {
+        const char* argv[] = { "--format=binary" };
+        CHECK(!run(bind, argv));
+        CHECK(bind.format == Format::kBinary);
+    }
+
+    {
+        const char* argv[] = { "--format", "jsno" };
+        const parser::ParseFailure fail = run(bind, argv);
+        CHECK((fail.code == ParseErrc::kInvalidChoice) and (fail.token == "jsno") and (fail.token_index == 1));
+        const suggest::Suggestions hints = fail.suggestions();
+        CHECK(!hints.empty() and (std::string_view(hints[0].name) == "json"));
+        CHECK(message(fail, msg) == "Input : jsno, Is not one of json|csv|tsv|binary for --format, did you mean json ?");
+        CHECK(bind.format == Format::kBinary);
+    }
+
+    {
+        // matching is exact
+        const char* argv[] = { "--format", "JSON" };
+        CHECK(run(bind, argv).code == ParseErrc::kInvalidChoice);
+    }
+
+    for(const char* word : { "on", "yes", "true", "1" }) {
+        const char* argv[] = { "--color", word };
+        bind.color = false;
+        CHECK(!run(bind, argv) and bind.color);
+    }
+
+    for(const char* word : { "off", "no", "false", "0" }) {
+        const char* argv[] = { "--color", word };
+        bind.color = true;
+        CHECK(!run(bind, argv) and !bind.color);
+    }
+
+    {
+        const char* argv[] = { "--color", "maybe" };
+        const parser::ParseFailure fail = run(bind, argv);
+        CHECK((fail.code == ParseErrc::kNotABoolean) and (fail.token == "maybe"));
+        CHECK(message(fail, msg) == "Input : maybe, Is not a boolean (true|false|yes|no|on|off|1|0)");
+    }
+
+    {
+        // a value starting with '-' is attached, a separate one would be taken as an option
+        const char* argv[] = { "--offset=-9000000000", "--size", "18446744073709551615", "--scale", "0.25", "--level=-42" };
+        CHECK(!run(bind, argv));
+        CHECK(bind.offset == -9000000000LL);
+        CHECK(bind.size == std::numeric_limits<U64T>::max());
+        CHECK(bind.scale == 0.25f);
+        CHECK(bind.level == -42);
+    }
+
+    {
+        const char* argv[] = { "--size=-1" };
+        CHECK(run(bind, argv).code != ParseErrc::kNone);
+    }
+
+    {
+        // past IntT, fits I64T
+        const char* argv[] = { "--level", "9000000000" };
+        CHECK(run(bind, argv).code == ParseErrc::kOutOfRange);
+    }
+
+    {
+        const char* argv[] = { "--offset", "12ab" };
+        CHECK(run(bind, argv).code == ParseErrc::kPartialNumber);
+    }
+
+    return check::result("conversion");
+}
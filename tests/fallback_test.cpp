@@ -0,0 +1,105 @@
+/*
+environment fallbacks : a flag whose value is a false word
+stays uncalled for the required and exclusive checks, a true
+word sets it, any other value fails
+*/
+#include <array>
+#include <cstdlib>
+#include <string_view>
+
+#include "ArgParser/static_parser.hpp"
+#include "ArgParser/fallback.hpp"
+#include "check.hpp"
+
+namespace {
+
+using namespace sp;
+
+static constexpr Context<5, 4, 0> ctx(
+    snOpt()("--force").required().env("P_FORCE"),
+    snOpt()("--quiet").exclude(1).env("P_QUIET"),
+    dnOpt()("--loud")["-l"].exclude(1),
+    snOpt()("--jobs").nargs(1).restricted().convert(codeInt).env("P_JOBS")
+);
+
+struct Bindings {
+    std::array<ModProf, 4> mprofs{};
+    IntT jobs = 0;
+    mapper::RuntimeMapper<5> rmap{ ctx.mapper, mprofs };
+
+    explicit Bindings(parser::Fallbacks& fallbacks) {
+        mprofs[3].bind(jobs);
+        rmap.verify();
+        fallbacks.attach(rmap);
+    }
+};
+
+}
+
+int main() {
+    ::setenv("P_FORCE", "0", 1);
+    ::setenv("P_QUIET", "off", 1);
+    ::setenv("P_JOBS", "6", 1);
+    parser::Fallbacks fallbacks;
+    Bindings bind(fallbacks);
+
+    {
+        // P_FORCE=0 doesn't satisfy the required --force
+        const char* argv[] = { "-l" };
+        const parser::ParseFailure fail = parser::run_parse(bind.rmap, argv, 1);
+        CHECK(fail.code == ParseErrc::kRequiredMissing);
+        CHECK((fail.profile != nullptr) and (std::string_view(profiles::get_name(*fail.profile)) == "--force"));
+    }
+
+    {
+        // P_QUIET=off doesn't call --quiet, -l isn't excluded
+        bind.rmap.reset();
+        const char* argv[] = { "--force", "-l" };
+        const parser::ParseFailure fail = parser::run_parse(bind.rmap, argv, 2);
+        CHECK(!fail);
+        CHECK(!bind.rmap.called_set().test(1));
+        CHECK(bind.jobs == 6);
+    }
+
+    {
+        bind.rmap.reset();
+        const char* argv[] = { "--force", "--quiet", "-l" };
+        const parser::ParseFailure fail = parser::run_parse(bind.rmap, argv, 3);
+        CHECK(fail.code == ParseErrc::kExcluded);
+    }
+
+    {
+        ::setenv("P_FORCE", "yes", 1);
+        parser::Fallbacks snapshot;
+        Bindings yes(snapshot);
+        const char* argv[] = { "-l" };
+        CHECK(!parser::run_parse(yes.rmap, argv, 1));
+        CHECK(yes.rmap.called_set().test(0));
+    }
+
+    {
+        ::setenv("P_FORCE", "garbage", 1);
+        parser::Fallbacks snapshot;
+        Bindings garbage(snapshot);
+        const char* argv[] = { "-l" };
+        const parser::ParseFailure fail = parser::run_parse(garbage.rmap, argv, 1);
+        CHECK((fail.code == ParseErrc::kFallbackNotABoolean) and (fail.token == "garbage"));
+        CHECK((fail.profile != nullptr) and (std::string_view(profiles::get_name(*fail.profile)) == "--force"));
+        CHECK(fail.token_index == parser::ParseFailure::npos);
+
+        char msg[160];
+        fail.format(msg);
+        CHECK(std::string_view(msg) == "Fallback value of --force is not a boolean (true|false|yes|no|on|off|1|0) : garbage");
+    }
+
+    {
+        ::setenv("P_FORCE", "on off", 1);
+        parser::Fallbacks snapshot;
+        Bindings surplus(snapshot);
+        const char* argv[] = { "-l" };
+        const parser::ParseFailure fail = parser::run_parse(surplus.rmap, argv, 1);
+        CHECK((fail.code == ParseErrc::kFallbackSurplus) and (fail.token == "off"));
+    }
+
+    return check::result("fallback");
+}
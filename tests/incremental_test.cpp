@@ -0,0 +1,161 @@
+/*
+incremental validation : after every edit of a line, update()
+from the first changed token must give what a full parse of
+the line gives (failure, profile states, bound values)
+*/
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "ArgParser/static_parser.hpp"
+#include "ArgParser/incremental.hpp"
+#include "check.hpp"
+
+namespace {
+
+using namespace sp;
+
+static constexpr Context<11, 9, 2> ctx(
+    dnOpt()("--jobs")["-j"].nargs(1).restricted().convert(codeInt).required(),
+    dnOpt()("--verbose")["-v"].call_lim(3),
+    snOpt()("--json").exclude(0),
+    snOpt()("--yaml").exclude(0),
+    snOpt()("--sizes").nargs(1).convert(codeInt).call_lim(2),
+    snOpt()("--lazy").nargs(2).restricted().convert(codeDob),
+    snOpt()("--name").nargs(1).restricted().convert(codeStr),
+    posArg()("pid").nargs(1).restricted().convert(codeInt).order(0),
+    posArg()("files").nargs(1).convert(codeStr).order(1)
+);
+
+struct Bindings {
+    std::array<ModProf, 9> mprofs{};
+    IntT jobs = 0;
+    std::array<Blob, 4> size_storage{};
+    ArrT sizes{ size_storage };
+    Lazy<DobT, 2> lazy;
+    StrT name = nullptr;
+    IntT pid = 0;
+    DynamicArr files;
+    mapper::RuntimeMapper<11> rmap{ ctx.mapper, mprofs };
+
+    Bindings() {
+        mprofs[0].bind(jobs);
+        mprofs[4].bind(sizes);
+        mprofs[5].bind(lazy);
+        mprofs[6].bind(name);
+        mprofs[7].bind(pid);
+        mprofs[8].bind(files);
+        rmap.verify();
+    }
+
+    bool called(std::size_t idx) const { return rmap.called_set().test(idx); }
+};
+
+// tokens are views of these literals, their storage stays across updates
+const char* const vocab[] = {
+    "--jobs", "-j", "4", "41", "x", "-v", "-vv", "-v1", "--verbose", "--json", "--yaml",
+    "--sizes", "1", "2", "3", "--lazy", "0.5", "1e3", "--name", "n", "f.txt", "12",
+    "--jbos", "--jobs=7", "--jobs1", "-j9", "--sizes=5", "-", "--"
+};
+
+/*
+true when the validated line matches the full parse, scalars
+only when the parse succeeded and their profile was called
+(the Validator leaves a dropped tail's scalar as it was)
+*/
+bool same_result(
+    const Bindings& inc, const parser::ParseFailure& inc_fail,
+    const Bindings& ref, const parser::ParseFailure& ref_fail
+) {
+    if((inc_fail.code != ref_fail.code) or (inc_fail.token_index != ref_fail.token_index)) return false;
+    if((inc_fail.profile != ref_fail.profile) or (inc_fail.token != ref_fail.token)) return false;
+
+    for(std::size_t i = 0; i < inc.mprofs.size(); i++) {
+        const ModProf& a = inc.mprofs[i];
+        const ModProf& b = ref.mprofs[i];
+        if((a.is_called != b.is_called) or (a.call_count != b.call_count) or (a.fulfilled_args != b.fulfilled_args))
+            return false;
+        if(inc.called(i) != ref.called(i)) return false;
+    }
+
+    if(inc.files.size() != ref.files.size()) return false;
+    for(std::size_t i = 0; i < inc.files.size(); i++)
+        if(inc.files[i] != ref.files[i]) return false;
+    if(inc.lazy.size() != ref.lazy.size()) return false;
+
+    if(ref_fail) return true;
+    if(inc.jobs != ref.jobs) return false;
+    if(ref.called(5)) {
+        const std::span<const DobT> a = inc.lazy.values();
+        const std::span<const DobT> b = ref.lazy.values();
+        for(std::size_t i = 0; i < a.size(); i++) if(a[i] != b[i]) return false;
+    }
+    if(ref.called(6) and (std::string_view(inc.name) != std::string_view(ref.name))) return false;
+    if(ref.called(7) and (inc.pid != ref.pid)) return false;
+    return true;
+}
+
+parser::ParseFailure full_parse(Bindings& ref, std::vector<const char*>& line) {
+    ref.rmap.reset();
+    return parser::run_parse(ref.rmap, line.data(), static_cast<int>(line.size()));
+}
+
+}
+
+int main() {
+    Bindings inc;
+    Bindings ref;
+    incremental::Validator<11, 8, 64> validator(inc.rmap);
+
+    {
+        std::vector<const char*> line{ "--jobs", "4", "--name", "n", "12", "f.txt" };
+        CHECK(!validator.update(line.data(), static_cast<int>(line.size())));
+        CHECK((inc.jobs == 4) and (inc.pid == 12) and (inc.files.size() == 1));
+
+        // the last token edited
+        line.back() = "--jbos";
+        const parser::ParseFailure fail = validator.update(line.data(), static_cast<int>(line.size()), line.size() - 1);
+        CHECK((fail.code == ParseErrc::kUnknownFlag) and (fail.token_index == 5));
+        CHECK(same_result(inc, fail, ref, full_parse(ref, line)));
+
+        // a token in the middle, the tail parses again
+        line.back() = "f.txt";
+        line[1] = "x";
+        const parser::ParseFailure middle = validator.update(line.data(), static_cast<int>(line.size()), 1);
+        CHECK((middle.code == ParseErrc::kNotANumber) and (middle.token_index == 1));
+        CHECK(same_result(inc, middle, ref, full_parse(ref, line)));
+
+        line[1] = "41";
+        CHECK(!validator.update(line.data(), static_cast<int>(line.size()), 1));
+        CHECK((inc.jobs == 41) and (std::string_view(inc.name) == "n"));
+        CHECK(same_result(inc, {}, ref, full_parse(ref, line)));
+    }
+
+    // random edits : append, drop the last token, replace one
+    std::mt19937 rng(42);
+    std::vector<const char*> line;
+    std::vector<const char*> prev;
+    int first_mismatch = -1;
+    for(int step = 0; step < 20000; step++) {
+        prev = line;
+        const unsigned op = rng() % 5;
+        if((op <= 2) or line.empty()) line.push_back(vocab[rng() % std::size(vocab)]);
+        else if(op == 3) line.pop_back();
+        else line[rng() % line.size()] = vocab[rng() % std::size(vocab)];
+        if(line.size() > 40) line.clear();
+
+        std::size_t first_changed = 0;
+        while((first_changed < line.size()) and (first_changed < prev.size()) and (line[first_changed] == prev[first_changed]))
+            ++first_changed;
+
+        const parser::ParseFailure inc_fail = validator.update(line.data(), static_cast<int>(line.size()), first_changed);
+        if(!same_result(inc, inc_fail, ref, full_parse(ref, line)) and (first_mismatch < 0))
+            first_mismatch = step;
+    }
+    CHECK(first_mismatch == -1);
+
+    return check::result("incremental");
+}
@@ -0,0 +1,74 @@
+/*
+response files : nested @files are expanded in place and
+unmapped when the RuntimeMapper resets
+*/
+#include <array>
+#include <cstdio>
+#include <string_view>
+
+#include "ArgParser/static_parser.hpp"
+#include "ArgParser/response_file.hpp"
+#include "check.hpp"
+
+namespace {
+
+using namespace sp;
+
+static constexpr Context<4, 3, 1> ctx(
+    dnOpt()("--nums")["-n"].nargs(1).convert(codeInt),
+    snOpt()("--name").nargs(1).restricted().convert(codeStr),
+    posArg()("files").nargs(1).convert(codeStr)
+);
+
+void write_file(const char* path, std::string_view content) {
+    if(std::FILE* file = std::fopen(path, "wb")) {
+        std::fwrite(content.data(), 1, content.size(), file);
+        std::fclose(file);
+    }
+}
+
+}
+
+int main() {
+    // outer.rsp ends on a token without a byte left for its NUL
+    write_file("outer.rsp", "-n 1 2 \"3\"\n--name 'hello world'\n@inner.rsp last");
+    write_file("inner.rsp", "  a b\tc  ");
+
+    std::array<ModProf, 3> mprofs{};
+    DynamicArr nums;
+    StrT name = nullptr;
+    DynamicArr files;
+    mprofs[0].bind(nums);
+    mprofs[1].bind(name);
+    mprofs[2].bind(files);
+    mapper::RuntimeMapper<4> rmap(ctx.mapper, mprofs);
+    rmap.verify();
+
+    {
+        parser::ResponseFiles<4, 4> rsp;
+        const char* argv[] = { "@outer.rsp", "tail" };
+        // more parses than MaxFiles, every reset unmaps the files of the previous one
+        for(int round = 0; round < 6; round++) {
+            rmap.reset();
+            CHECK(rsp.mapped_files() == 0);
+            const parser::ParseFailure fail = parser::run_parse(rmap, argv, 2, rsp);
+            CHECK(!fail);
+            CHECK(rsp.mapped_files() == 2);
+        }
+        CHECK((nums.size() == 3) and (std::get<IntT>(nums[2]) == 3));
+        CHECK(std::string_view(name) == "hello world");
+        CHECK(files.size() == 5);
+        CHECK(std::string_view(std::get<StrT>(files[2])) == "c");
+        CHECK(std::string_view(std::get<StrT>(files[3])) == "last");
+        CHECK(std::string_view(std::get<StrT>(files[4])) == "tail");
+        CHECK(rmap.get_reset_hook().owner == &rsp);
+    }
+
+    // the destroyed ResponseFiles detached itself
+    CHECK(!rmap.get_reset_hook());
+    rmap.reset();
+
+    std::remove("outer.rsp");
+    std::remove("inner.rsp");
+    return check::result("response_file");
+}
@@ -0,0 +1,25 @@
+#!/bin/sh
+# Builds and runs every functional test, *_test.cpp as C++20
+# except try_parse_test.cpp (std::expected, C++23). stops at the
+# first failing test
+#
+#   CXX=clang++ ./tests/run.sh
+#   CXXFLAGS="-fsanitize=address,undefined" ./tests/run.sh
+
+set -e
+
+CXX=${CXX:-g++}
+HERE=$(cd "$(dirname "$0")" && pwd)
+OUT=${OUT:-"$HERE/out"}
+
+mkdir -p "$OUT"
+
+for src in "$HERE"/*_test.cpp; do
+    name=$(basename "$src" .cpp)
+    std=c++20
+    [ "$name" = try_parse_test ] && std=c++23
+    "$CXX" -std=$std -O1 -g $CXXFLAGS \
+        -I"$HERE/../include" -I"$HERE" \
+        "$src" -o "$OUT/$name"
+    (cd "$OUT" && "./$name")
+done
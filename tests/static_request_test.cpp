@@ -0,0 +1,133 @@
+/*
+compile-time Requests (make_rcontext<Ctx> with bind_to / on_call) :
+a PreVerified RuntimeContext parses as the same Requests placed
+by name and verify()'d at runtime
+*/
+#include <array>
+#include <string_view>
+
+#include "ArgParser/static_parser.hpp"
+#include "check.hpp"
+
+namespace {
+
+using namespace sp;
+
+static constexpr choice::ChoiceSet formats{ "json", "csv" };
+enum class Format { kJson, kCsv };
+
+static constexpr Context<2, 2, 0> list_ctx(
+    snOpt()("--all"),
+    snOpt()("--depth").nargs(1).restricted().convert(codeInt)
+);
+
+static constexpr Context<9, 8, 1> ctx(
+    dnOpt()("--count")["-c"].nargs(1).restricted().convert(codeInt),
+    snOpt()("--ports").nargs(2).convert(codeInt),
+    snOpt()("--format").nargs(1).restricted().choices(formats),
+    snOpt()("--color").nargs(1).restricted().convert(codeBool),
+    snOpt()("--name").nargs(1).restricted().convert(codeStr),
+    snOpt()("--help"),
+    posArg()("files").nargs(1).convert(codeStr),
+    subCmd()("list").context(list_ctx)
+);
+
+struct Values {
+    IntT count = 0;
+    std::array<Blob, 4> ports{};
+    Format format = Format::kJson;
+    BoolT color = false;
+    StrT name = nullptr;
+    std::size_t help_calls = 0;
+    DynamicArr files;
+    IntT depth = 0;
+
+    ModProf::FunctionType on_help() {
+        return [this](const profiles::static_profile&, ModProf&) { ++help_calls; };
+    }
+};
+
+bool same_values(const Values& a, const Values& b) {
+    if((a.count != b.count) or (a.ports != b.ports) or (a.format != b.format) or (a.color != b.color)) return false;
+    if((a.name == nullptr) != (b.name == nullptr)) return false;
+    if(a.name and (std::string_view(a.name) != std::string_view(b.name))) return false;
+    if((a.help_calls != b.help_calls) or (a.depth != b.depth) or (a.files.size() != b.files.size())) return false;
+    for(std::size_t i = 0; i < a.files.size(); i++) if(a.files[i] != b.files[i]) return false;
+    return true;
+}
+
+}
+
+int main() {
+    Values pre;
+    auto pre_list = make_sub_rcontext(list_ctx, Request(ModProf().bind(pre.depth), "--depth"));
+    auto pre_rctx = make_rcontext<ctx>(
+        bind_to<"-c">(pre.count),
+        bind_to<"--ports">(pre.ports),
+        bind_to<"--format">(pre.format),
+        bind_to<"--color">(pre.color),
+        bind_to<"--name">(pre.name),
+        on_call<"--help">(pre.on_help()),
+        bind_to<"files">(pre.files),
+        bind_to<"list">(pre_list)
+    );
+    CHECK(pre_rctx.mapper.verified());
+
+    Values run;
+    auto run_list = make_sub_rcontext(list_ctx, Request(ModProf().bind(run.depth), "--depth"));
+    auto run_rctx = make_rcontext(
+        ctx,
+        Request(ModProf().bind(run.count), "--count"),
+        Request(ModProf().bind(run.ports), "--ports"),
+        Request(ModProf().bind(run.format), "--format"),
+        Request(ModProf().bind(run.color), "--color"),
+        Request(ModProf().bind(run.name), "--name"),
+        Request(ModProf().set_callback(run.on_help()), "--help"),
+        Request(ModProf().bind(run.files), "files"),
+        Request(ModProf().bind_subcommand(subcommand(run_list)), "list")
+    );
+
+    std::size_t runs = 0;
+    std::size_t mismatches = 0;
+    // parses with both, counts a mismatch of the failures, called sets or values
+    auto both = [&](std::initializer_list<const char*> tokens) {
+        std::array<const char*, 16> argv{};
+        std::size_t argc = 0;
+        for(const char* token : tokens) argv[argc++] = token;
+        pre_rctx.reset();
+        run_rctx.reset();
+        const parser::ParseFailure a = parser::run_parse(pre_rctx.mapper, argv.data(), static_cast<int>(argc));
+        const parser::ParseFailure b = parser::run_parse(run_rctx.mapper, argv.data(), static_cast<int>(argc));
+        ++runs;
+        bool same = (a.code == b.code) and (a.token_index == b.token_index) and (a.token == b.token);
+        same = same and ((a.profile == nullptr) == (b.profile == nullptr));
+        if(a.profile and b.profile)
+            same = same and (std::string_view(profiles::get_name(*a.profile)) == profiles::get_name(*b.profile));
+        for(std::size_t i = 0; i < ctx.id_count; i++)
+            same = same and (pre_rctx.mapper.called_set().test(i) == run_rctx.mapper.called_set().test(i));
+        same = same and (pre_list.mapper.verified() == run_list.mapper.verified());
+        if(!a) same = same and same_values(pre, run);
+        if(!same) ++mismatches;
+        return a.code;
+    };
+
+    CHECK(both({ "-c", "3", "--ports", "80", "443", "--format", "csv", "--color=on", "--name", "n", "a", "b" }) == ParseErrc::kNone);
+    CHECK((pre.count == 3) and (pre.format == Format::kCsv) and pre.color and (pre.files.size() == 2));
+    CHECK(std::get<IntT>(pre.ports[1]) == 443);
+
+    CHECK(both({ "--help", "--count=9" }) == ParseErrc::kNone);
+    CHECK((pre.help_calls == 1) and (pre.count == 9));
+
+    CHECK(both({ "-c", "1", "list", "--all", "--depth", "4" }) == ParseErrc::kNone);
+    CHECK((pre.depth == 4) and pre_list.mapper.verified());
+
+    CHECK(both({ "--format", "xml" }) == ParseErrc::kInvalidChoice);
+    CHECK(both({ "--color", "maybe" }) == ParseErrc::kNotABoolean);
+    CHECK(both({ "-c", "x" }) == ParseErrc::kNotANumber);
+    CHECK(both({ "--cuont", "1" }) == ParseErrc::kUnknownFlag);
+    CHECK(both({ "-c", "1", "-c", "2" }) == ParseErrc::kCallLimit);
+    CHECK(both({ "list", "--depth" }) == ParseErrc::kInsufficientNarg);
+    CHECK((runs == 9) and (mismatches == 0));
+
+    return check::result("static_request");
+}
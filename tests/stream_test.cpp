@@ -0,0 +1,112 @@
+/*
+parse_stream over a pipe : call_limit holds across the
+occurrences of an option, a trailing partial record reports
+the count of tokens its required posargs miss
+*/
+#include <array>
+#include <cstring>
+#include <string_view>
+
+#include <unistd.h>
+
+#include "ArgParser/static_parser.hpp"
+#include "ArgParser/stream.hpp"
+#include "check.hpp"
+
+namespace {
+
+using namespace sp;
+
+static constexpr Context<5, 5, 3> ctx(
+    snOpt()("--tag").nargs(1).restricted().convert(codeStr).call_lim(2),
+    snOpt()("--once").nargs(1).restricted().convert(codeStr),
+    posArg()("src").nargs(1).restricted().convert(codeStr).required().order(0),
+    posArg()("mode").nargs(1).restricted().convert(codeStr).required().order(1),
+    posArg()("dst").nargs(2).restricted().convert(codeStr).order(2)
+);
+
+struct Bindings {
+    std::array<ModProf, 5> mprofs{};
+    StrT tag = nullptr;
+    StrT once = nullptr;
+    StrT src = nullptr;
+    StrT mode = nullptr;
+    std::array<Blob, 2> dst_storage{};
+    ArrT dst{ dst_storage };
+    std::size_t tags = 0;
+    mapper::RuntimeMapper<5> rmap{ ctx.mapper, mprofs };
+
+    Bindings() {
+        mprofs[0].bind(tag).set_callback([this](const profiles::static_profile&, profiles::modifiable_profile&) { ++tags; });
+        mprofs[1].bind(once);
+        mprofs[2].bind(src);
+        mprofs[3].bind(mode);
+        mprofs[4].bind(dst);
+        rmap.verify();
+    }
+};
+
+// streams input through a pipe
+parser::ParseFailure stream(Bindings& bind, std::string_view input, parser::StreamStats& stats) {
+    int fds[2];
+    if(::pipe(fds) != 0) return parser::ParseFailure{ ParseErrc::kStreamRead };
+    const ssize_t written = ::write(fds[1], input.data(), input.size());
+    ::close(fds[1]);
+    parser::FdTokenSource<256> src(fds[0]);
+    const parser::ParseFailure fail = (written == static_cast<ssize_t>(input.size()))
+        ? parser::run_stream(bind.rmap, src, stats)
+        : parser::ParseFailure{ ParseErrc::kStreamRead };
+    ::close(fds[0]);
+    return fail;
+}
+
+}
+
+int main() {
+    {
+        Bindings bind;
+        parser::StreamStats stats{};
+        const parser::ParseFailure fail = stream(bind, "--tag a x r y z --tag b --once c", stats);
+        CHECK(!fail);
+        CHECK((bind.tags == 2) and (stats.records == 1));
+    }
+
+    {
+        // call_lim(2), the third occurrence fails
+        Bindings bind;
+        parser::StreamStats stats{};
+        const parser::ParseFailure fail = stream(bind, "--tag a --tag b --tag c", stats);
+        CHECK(fail.code == ParseErrc::kCallLimit);
+        CHECK((fail.detail == 2) and (bind.tags == 2));
+    }
+
+    {
+        Bindings bind;
+        parser::StreamStats stats{};
+        const parser::ParseFailure fail = stream(bind, "--once a --once b", stats);
+        CHECK(fail.code == ParseErrc::kCallLimit);
+        CHECK(fail.detail == 1);
+    }
+
+    {
+        // one full record, then src only : the required mode misses 1 token, dst is optional
+        Bindings bind;
+        parser::StreamStats stats{};
+        const parser::ParseFailure fail = stream(bind, "a r b c  d", stats);
+        CHECK(fail.code == ParseErrc::kInsufficientNarg);
+        CHECK(fail.detail == 1);
+        CHECK((fail.profile != nullptr) and (std::string_view(profiles::get_name(*fail.profile)) == "mode"));
+        CHECK(stats.records == 1);
+    }
+
+    {
+        // the last record only misses the optional dst
+        Bindings bind;
+        parser::StreamStats stats{};
+        const parser::ParseFailure fail = stream(bind, "a r b c d s", stats);
+        CHECK(!fail);
+        CHECK(stats.records == 2);
+    }
+
+    return check::result("stream");
+}
@@ -0,0 +1,98 @@
+/*
+subcommands : the first bare token naming one selects it, the
+rest of the tokens go to its own RuntimeMapper, verified only
+when selected (a bad binding then fails with kSubcommandSetup)
+*/
+#include <array>
+#include <string_view>
+
+#include "ArgParser/static_parser.hpp"
+#include "check.hpp"
+
+namespace {
+
+using namespace sp;
+
+static constexpr Context<2, 2, 0> list_ctx(
+    snOpt()("--all"),
+    snOpt()("--depth").nargs(1).restricted().convert(codeInt)
+);
+
+static constexpr Context<1, 1, 0> rm_ctx(
+    snOpt()("--force")
+);
+
+static constexpr Context<5, 4, 0> ctx(
+    dnOpt()("--verbose")["-v"],
+    subCmd()("list").context(list_ctx),
+    subCmd()("rm").context(rm_ctx),
+    snOpt()("--jobs").nargs(1).restricted().convert(codeInt)
+);
+
+}
+
+int main() {
+    std::array<ModProf, 2> list_mprofs{};
+    IntT depth = 0;
+    list_mprofs[1].bind(depth);
+    mapper::RuntimeMapper<2> list_rmap(list_ctx.mapper, list_mprofs);
+
+    // rm's single profile bound to a value it doesn't take
+    std::array<ModProf, 1> rm_mprofs{};
+    IntT wrong = 0;
+    rm_mprofs[0].bind(wrong);
+    mapper::RuntimeMapper<1> rm_rmap(rm_ctx.mapper, rm_mprofs);
+
+    std::array<ModProf, 4> mprofs{};
+    IntT jobs = 0;
+    std::size_t verbose_calls = 0;
+    mprofs[0].set_callback([&](const profiles::static_profile&, profiles::modifiable_profile&) { ++verbose_calls; });
+    mprofs[1].bind_subcommand(parser::subcommand(list_rmap));
+    mprofs[2].bind_subcommand(parser::subcommand(rm_rmap));
+    mprofs[3].bind(jobs);
+    mapper::RuntimeMapper<5> rmap(ctx.mapper, mprofs);
+    rmap.verify();
+
+    {
+        const char* argv[] = { "-v", "--jobs", "2", "list", "--all", "--depth", "3" };
+        CHECK(!parser::run_parse(rmap, argv, 7));
+        CHECK((jobs == 2) and (verbose_calls == 1));
+        CHECK(mprofs[1].is_called and !mprofs[2].is_called);
+        CHECK(list_rmap.verified() and !rm_rmap.verified());
+        CHECK(list_rmap.called_set().test(0) and (depth == 3));
+    }
+
+    {
+        // options after the subcommand name are the child's
+        rmap.reset();
+        CHECK(!list_rmap.called_set().any());
+        const char* argv[] = { "list", "--jobs", "2" };
+        const parser::ParseFailure fail = parser::run_parse(rmap, argv, 3);
+        CHECK(fail.code == ParseErrc::kUnknownFlag);
+        CHECK((fail.token == "--jobs") and (fail.token_index == 1));
+    }
+
+    {
+        // rm isn't selected, its bindings aren't checked
+        rmap.reset();
+        const char* argv[] = { "--jobs", "4" };
+        CHECK(!parser::run_parse(rmap, argv, 2));
+        CHECK(!rm_rmap.verified() and (jobs == 4));
+    }
+
+    {
+        rmap.reset();
+        const char* argv[] = { "-v", "rm", "--force" };
+        const parser::ParseFailure fail = parser::run_parse(rmap, argv, 3);
+        CHECK(fail.code == ParseErrc::kSubcommandSetup);
+        CHECK((fail.profile != nullptr) and (profiles::get_name(*fail.profile) == std::string_view("rm")));
+        CHECK(!fail.token.empty() and (fail.token_index == parser::ParseFailure::npos));
+        CHECK(!rm_rmap.verified());
+
+        char msg[256];
+        fail.format(msg);
+        CHECK(std::string_view(msg).starts_with("Subcommand \"rm\" has invalid bindings : "));
+    }
+
+    return check::result("subcommand");
+}
@@ -0,0 +1,69 @@
+/*
+try_parse reports every failure through std::expected (C++23),
+bindings not matching the Context included
+*/
+#include <array>
+
+#include "ArgParser/static_parser.hpp"
+#include "check.hpp"
+
+#ifndef __cpp_lib_expected
+#error "try_parse_test needs std::expected (build with -std=c++23, see run.sh)"
+#endif
+
+namespace {
+
+using namespace sp;
+
+static constexpr Context<3, 2, 0> ctx(
+    dnOpt()("--jobs")["-j"].nargs(1).restricted().convert(codeInt),
+    snOpt()("--name").nargs(1).restricted().convert(codeStr)
+);
+
+}
+
+int main() {
+    {
+        std::array<ModProf, 2> mprofs{};
+        IntT jobs = 0;
+        StrT name = nullptr;
+        mprofs[0].bind(jobs);
+        mprofs[1].bind(name);
+        mapper::RuntimeMapper<3> rmap(ctx.mapper, mprofs);
+
+        // verified by the first parse
+        const char* good[] = { "-j", "4", "--name", "tool" };
+        CHECK(parser::try_parse(rmap, good, 4).has_value());
+        CHECK(rmap.verified() and (jobs == 4));
+
+        rmap.reset();
+        const char* bad[] = { "--name", "tool", "--jobs", "x4" };
+        auto res = parser::try_parse(rmap, bad, 4);
+        CHECK(!res.has_value());
+        CHECK(res.error().code == ParseErrc::kNotANumber);
+        CHECK(res.error().token_index == 3);
+    }
+
+    {
+        // --jobs is kInt, bound to a string
+        std::array<ModProf, 2> mprofs{};
+        StrT jobs = nullptr;
+        StrT name = nullptr;
+        mprofs[0].bind(jobs);
+        mprofs[1].bind(name);
+        mapper::RuntimeMapper<3> rmap(ctx.mapper, mprofs);
+
+        const char* argv[] = { "-j", "4" };
+        auto res = parser::try_parse(rmap, argv, 2);
+        CHECK(!res.has_value());
+        CHECK(res.error().code == ParseErrc::kMapperSetup);
+        CHECK(res.error().token_index == parser::ParseFailure::npos);
+        CHECK(!rmap.verified());
+
+        char msg[256];
+        res.error().format(msg);
+        CHECK(std::string_view(msg).starts_with("RuntimeMapper has invalid bindings : "));
+    }
+
+    return check::result("try_parse");
+}
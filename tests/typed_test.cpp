@@ -0,0 +1,163 @@
+/*
+typed mode : short name clusters, call_limit, required and
+exclusive profiles behave as in parser::run_parse, bool values
+and enum (choices) fields convert as a RuntimeMapper binding does
+*/
+#include <string_view>
+
+#include "ArgParser/typed.hpp"
+#include "check.hpp"
+
+namespace {
+
+using namespace sp;
+
+struct Opts {
+    bool extract = false;
+    bool verbose = false;
+    const char* file = nullptr;
+    int level = 0;
+    typed::List<int, 4> ports{};
+    bool quiet = false;
+    bool loud = false;
+    const char* target = nullptr;
+};
+
+static constexpr auto tctx = typed::make_context<Opts>(
+    typed::field<&Opts::extract>(dnOpt()("--extract")["-x"]),
+    typed::field<&Opts::verbose>(dnOpt()("--verbose")["-v"].call_lim(3)),
+    typed::field<&Opts::file>(dnOpt()("--file")["-f"].nargs(1).restricted().convert(codeStr)),
+    typed::field<&Opts::level>(dnOpt()("--level")["-n"].nargs(1).restricted().convert(codeInt)),
+    typed::field<&Opts::ports>(snOpt()("--ports").nargs(1).convert(codeInt)),
+    typed::field<&Opts::quiet>(dnOpt()("--quiet")["-q"].exclude(1)),
+    typed::field<&Opts::loud>(dnOpt()("--loud")["-l"].exclude(1)),
+    typed::field<&Opts::target>(posArg()("target").nargs(1).restricted().convert(codeStr).required())
+);
+
+static constexpr choice::ChoiceSet formats{ "json", "csv", "tsv" };
+enum class Format { kJson, kCsv, kTsv };
+
+struct Output {
+    bool color = false;
+    bool force = false;
+    Format format = Format::kJson;
+    typed::List<Format, 3> extra{};
+    bool dry = false;
+};
+
+static constexpr auto output_ctx = typed::make_context<Output>(
+    typed::field<&Output::color>(snOpt()("--color").nargs(1).restricted().convert(codeBool)),
+    typed::field<&Output::force>(dnOpt()("--force")["-f"]),
+    typed::field<&Output::format>(dnOpt()("--format")["-F"].nargs(1).restricted().choices(formats)),
+    typed::field<&Output::extra>(snOpt()("--also").nargs(1).choices(formats)),
+    typed::field<&Output::dry>(posArg()("dry").nargs(1).restricted().convert(codeBool))
+);
+
+template <std::size_t N>
+parser::ParseFailure run(Output& out, const char* (&argv)[N]) {
+    out = Output{};
+    return typed::run_parse(output_ctx, out, argv, static_cast<int>(N));
+}
+
+template <std::size_t N>
+parser::ParseFailure run(Opts& opts, const char* (&argv)[N]) {
+    opts = Opts{};
+    return typed::run_parse(tctx, opts, argv, static_cast<int>(N));
+}
+
+}
+
+int main() {
+    Opts opts{};
+
+    {
+        const char* argv[] = { "-xvf", "archive.tar", "dest" };
+        CHECK(!run(opts, argv));
+        CHECK(opts.extract and opts.verbose);
+        CHECK(std::string_view(opts.file) == "archive.tar");
+        CHECK(std::string_view(opts.target) == "dest");
+    }
+
+    {
+        // the first member taking values gets the rest of the token
+        const char* argv[] = { "-vfout.txt", "-vn5", "dest" };
+        CHECK(!run(opts, argv));
+        CHECK(std::string_view(opts.file) == "out.txt");
+        CHECK(opts.level == 5);
+    }
+
+    {
+        const char* argv[] = { "-xo", "dest" };
+        const parser::ParseFailure fail = run(opts, argv);
+        CHECK(fail.code == ParseErrc::kUnknownFlag);
+        CHECK((fail.token_index == 0) and (fail.detail == 2));
+    }
+
+    {
+        const char* argv[] = { "-vv", "-v", "--verbose", "dest" };
+        const parser::ParseFailure fail = run(opts, argv);
+        CHECK(fail.code == ParseErrc::kCallLimit);
+        CHECK((fail.token_index == 2) and (fail.detail == 3));
+    }
+
+    {
+        const char* argv[] = { "-n", "1", "dest", "--level=2" };
+        const parser::ParseFailure fail = run(opts, argv);
+        CHECK(fail.code == ParseErrc::kCallLimit);
+        CHECK(fail.token_index == 3);
+    }
+
+    {
+        const char* argv[] = { "-ql", "dest" };
+        const parser::ParseFailure fail = run(opts, argv);
+        CHECK(fail.code == ParseErrc::kExcluded);
+        CHECK((fail.profile != nullptr) and (std::string_view(profiles::get_name(*fail.profile)) == "--loud"));
+        CHECK(fail.token == "--quiet");
+    }
+
+    {
+        const char* argv[] = { "-v", "--ports", "80", "443" };
+        const parser::ParseFailure fail = run(opts, argv);
+        CHECK(fail.code == ParseErrc::kRequiredMissing);
+        CHECK((fail.profile != nullptr) and (std::string_view(profiles::get_name(*fail.profile)) == "target"));
+        CHECK(opts.ports.size() == 2);
+    }
+
+    Output out{};
+
+    {
+        const char* argv[] = { "no", "--color", "on", "-fFcsv", "--also", "tsv", "json" };
+        CHECK(!run(out, argv));
+        CHECK(out.color and out.force and !out.dry);
+        CHECK(out.format == Format::kCsv);
+        CHECK((out.extra.size() == 2) and (out.extra[0] == Format::kTsv) and (out.extra[1] == Format::kJson));
+    }
+
+    {
+        const char* argv[] = { "--color=off", "--format=tsv", "yes" };
+        CHECK(!run(out, argv));
+        CHECK(!out.color and out.dry and (out.format == Format::kTsv));
+    }
+
+    {
+        const char* argv[] = { "--format", "jsno" };
+        const parser::ParseFailure fail = run(out, argv);
+        CHECK((fail.code == ParseErrc::kInvalidChoice) and (fail.token_index == 1));
+        CHECK((fail.profile != nullptr) and (std::string_view(profiles::get_name(*fail.profile)) == "--format"));
+        const suggest::Suggestions hints = fail.suggestions();
+        CHECK(!hints.empty() and (std::string_view(hints[0].name) == "json"));
+    }
+
+    {
+        const char* argv[] = { "--color", "maybe" };
+        const parser::ParseFailure fail = run(out, argv);
+        CHECK((fail.code == ParseErrc::kNotABoolean) and (fail.token == "maybe"));
+    }
+
+    {
+        const char* argv[] = { "sure" };
+        CHECK(run(out, argv).code == ParseErrc::kNotABoolean);
+    }
+
+    return check::result("typed");
+}
@@ -0,0 +1,76 @@
+/*
+HelpText : the usage line and the help rendered at compile
+time, columns aligned on the widest entry within kMaxLeftColumn,
+a wider one gets its description on the next line
+*/
+#include <string_view>
+
+#include "ArgParser/static_parser.hpp"
+#include "ArgParser/usage.hpp"
+#include "check.hpp"
+
+namespace {
+
+using namespace sp;
+
+static constexpr choice::ChoiceSet formats{ "json", "csv" };
+
+static constexpr Context<1, 1, 0> list_ctx(
+    snOpt()("--all").describe("every job")
+);
+
+static constexpr Context<12, 10, 2> ctx(
+    dnOpt()("--limit")["-l"].nargs(1).restricted().convert(codeInt).describe("max jobs").env("JOBS_LIMIT"),
+    dnOpt()("--verbose")["-v"].describe("talk more").call_lim(3),
+    snOpt()("--json").exclude(0).describe("print json"),
+    snOpt()("--yaml").exclude(0),
+    snOpt()["-q"],
+    snOpt()("--areallylongoptionnameabc").nargs(2).restricted().convert(codeDob).describe("pair"),
+    snOpt()("--format").nargs(1).restricted().choices(formats).config("format"),
+    posArg()("pid").nargs(1).restricted().convert(codeInt).required().order(0).describe("process id"),
+    posArg()("files").nargs(1).convert(codeStr).order(1),
+    subCmd()("list").context(list_ctx).describe("list the jobs")
+);
+
+constexpr std::string_view kHelp =
+    "usage: jobs [options] <pid> [<files>...] <command> ...\n"
+    "\n"
+    "arguments:\n"
+    "  pid <int>                process id (required)\n"
+    "  files <str>...\n"
+    "\n"
+    "options:\n"
+    "  -l, --limit <int>        max jobs (env JOBS_LIMIT)\n"
+    "  -v, --verbose            talk more (up to 3 times)\n"
+    "      --json               print json (not with --yaml)\n"
+    "      --yaml               (not with --json)\n"
+    "  -q\n"
+    "      --areallylongoptionnameabc <num> <num>\n"
+    "                           pair\n"
+    "      --format <json|csv>  (config format)\n"
+    "\n"
+    "commands:\n"
+    "  list                     list the jobs\n";
+
+constexpr std::string_view kListHelp =
+    "usage: jobs list [options]\n"
+    "\n"
+    "options:\n"
+    "      --all  every job\n";
+
+}
+
+int main() {
+    using Help = usage::HelpText<ctx, "jobs">;
+    const std::string_view help = Help::view();
+    CHECK(help == kHelp);
+    CHECK(Help::length == kHelp.size());
+    // rendered during constant evaluation
+    static_assert(Help::view().starts_with("usage: jobs [options] <pid> [<files>...] <command> ...\n"));
+
+    CHECK(usage::HelpText<list_ctx, "jobs list">::view() == kListHelp);
+
+    // shows what was rendered on a mismatch
+    if(help != kHelp) Help::write();
+    return check::result("usage");
+}